@@ -185,17 +185,19 @@ static struct internal_hash_t {
 	EVAL(STRING,"string"),		// 
 	EVAL(DOUBLE,"double"),		// 
 	EVAL(SEQUENCE,"sequence"),	// 
-	EVAL(CONST,	"const"),		// find a better way : > "delcaration" before type
-								// for now, just assume the keyword after const is a right type.
+	EVAL(CONST,	"const"),		// const type NAME = expression; (see parse_const())
+	EVAL(MAP,	"map"),			// map<key, value[, size]>
 
 	// Base -------------------------------------------------------------------
 	EVAL(STRUCT,"struct"),		// 
 	EVAL(MODULE,"module"),		// 
 	EVAL(TYPEDEF,"typedef"),	// 
+	EVAL(ENUM,	"enum"),		// 
+	EVAL(UNION,	"union"),		// switch(type) { case X: ... }
+	EVAL(BITSET,"bitset"),		// bitfield<N[, type]>
+	EVAL(BITMASK,"bitmask"),	// 
+	EVAL(INTERFACE,"interface"),// operation(s) only
 	/** TODO: 
-	 * 'map'
-	 * 'bitset'
-	 * 'bitmask'
 	 * ...
 	 * ref(s) :
 	 * https://www.omg.org/spec/IDL/4.2/PDF
@@ -204,6 +206,33 @@ static struct internal_hash_t {
 
 }; // internal_hash_t
 
+/** in-memory size of the built-in types, -1 if not fixed (same order) */
+static const int __internal_size[LAST_TYPE] = {
+	0,	// void
+	1,	// octet
+	1,	// int8_t
+	2,	// int16_t
+	2,	// short
+	4,	// int32_t
+	4,	// int
+	4,	// long (IDL long is 32 bits)
+	8,	// int64_t
+	8,	// long long
+	1,	// uint8_t
+	2,	// uint16_t
+	4,	// uint32_t
+	8,	// uint64_t
+	1,	// bool
+	1,	// boolean
+	1,	// char
+	4,	// float
+	-1,	// string
+	8,	// double
+	-1,	// sequence
+	0,	// const
+	-1,	// map
+};
+
 // ----------------------------------------------------------------------------
 void Parser::minify(const char* code, String &result)
 {
@@ -234,18 +263,10 @@ const char* Parser::getName(hash_t hash)
 			return __internal_hash[i].name;
 	}
 
-	// user type
-	for (i = 0; i < typedefs.size(); ++i)
-	{
-		if (hash == typedefs[i].hash)
-			return typedefs[i].name;
-	}
-	// struct
-	for (i = 0; i < structs.size(); ++i)
-	{
-		if (hash == structs[i].hash)
-			return structs[i].name;
-	}
+	// user type / struct
+	Map<hash_t, int>::iterator it = types.find(hash);
+	if (it != types.end())
+		return type2Name(it->second);
 
 	//ne_assert(0);
 
@@ -259,6 +280,7 @@ const char* Parser::type2Name(int type)
 	// user type
 	if (type >= USER_BASE_SPACER_STRUCT)	return structs[type - USER_BASE_SPACER_STRUCT].name;
 	if (type >= USER_BASE_SPACER_TYPEDEF)	return typedefs[type - USER_BASE_SPACER_TYPEDEF].name;
+	if (type >= USER_BASE_SPACER_ENUM)		return enums[type - USER_BASE_SPACER_ENUM].name;
 	// base type
 	if (type >= BASE_SPACER)		return __internal_hash[type - BASE_SPACER].name;
 	// builtin type
@@ -280,64 +302,200 @@ int Parser::getType(const hash_t& hash)
 }
 
 Typedef_t Parser::getRealType(const hash_t& hash)
+{
+	int id;
+
+	if (is_builtin_type(hash, id) || is_user_base(hash, id))
+		return id2Type(id);
+
+	error("unknown type: %x\n",hash);
+
+	return Typedef_t();
+}
+
+Typedef_t Parser::id2Type(int id)
 {
 	Typedef_t t;
-	int i;
 
-	// built-in type
-	for (i = 0; i < LAST_TYPE; ++i)
+	// structs
+	if (id >= USER_BASE_SPACER_STRUCT)
 	{
-		if (hash == __internal_hash[i].hash)
-		{
-			t.hash = hash;
-			t.name = __internal_hash[i].name;
-			t.type = i+TYPE_SPACER;
-			return t;
-		}
+		const Struct_t& str = structs[id - USER_BASE_SPACER_STRUCT];
+		t.hash = str.hash;
+		t.name = str.name;
+		t.nameSpan = str.nameSpan;
+		t.nameSpace = str.nameSpace;
+		t.baseName = t.name; // user type
+		t.scope = str.scope;
+		t.type = ID_STRUCT + USER_BASE_SPACER_STRUCT;
 	}
-
 	// typedef
-	for (i = 0; i < typedefs.size(); ++i)
+	else if (id >= USER_BASE_SPACER_TYPEDEF)
 	{
-		error("type: %s %x\n", typedefs[i].name.c_str(), typedefs[i].hash );
+		int i = id - USER_BASE_SPACER_TYPEDEF;
 
-		if (typedefs[i].hash == hash)
+		/** resolved once, see resolve() */
+		if ( i < resolving.size() && resolving[i] == 2 )
+			return resolved[i];
+		if ( i < resolving.size() && resolving[i] == 1 )
 		{
-			t = typedefs[i];
+			TRACE_ERROR("recursive typedef: " << typedefs[i].nameSpan);
+			return typedefs[i];
+		}
+		if ( i < resolving.size() ) resolving[i] = 1;
 
-			if ( t.baseName.size() )
+		const Typedef_t& td = typedefs[i];
+		t = td;
+
+		if ( td.node >= 0 )
+		{
+			// keep base info (original type + size)
+			t = node2Type( td.node, td.scope );
+			if ( td.type != ID_SEQUENCE + TYPE_SPACER )
 			{
-				hash_t hash = getHash( t.baseName );
-				// keep base info (original type + size
-				int tt = t.type;
-				int ts = t.size;
-				t = getRealType( hash );
-				t.type = tt;
-				t.size = ts;
+				t.type = td.type;
+				if ( td.size >= 0 ) t.size = td.size;
 			}
-			return t;
+		}
+
+		if ( i < resolving.size() )
+		{
+			resolved[i] = t;
+			resolving[i] = 2;
 		}
 	}
-	
-	// structs
-	for (i = 0; i < structs.size(); ++i)
+	// enum
+	else if (id >= USER_BASE_SPACER_ENUM)
 	{
-		// error("type: %s %x\n", structs[i].name.c_str(), structs[i].hash );
+		const Enum_t& e = enums[id - USER_BASE_SPACER_ENUM];
+		t.hash = e.hash;
+		t.name = e.name;
+		t.nameSpan = e.nameSpan;
+		t.nameSpace = e.nameSpace;
+		t.baseName = t.name; // user type
+		t.scope = e.scope;
+		t.type = id;
+	}
+	// built-in type
+	else if (id >= TYPE_SPACER && id < TYPE_SPACER + LAST_TYPE)
+	{
+		t.hash = __internal_hash[id - TYPE_SPACER].hash;
+		t.name = __internal_hash[id - TYPE_SPACER].name;
+		t.type = id;
+	}
+
+	return t;
+}
+
+// ----------------------------------------------------------------------------
+int Parser::find_scope(const Span_t& name, bool absolute, int from)
+{
+	/**
+	 * "A::B" from a scope : A is searched from the scope up to the global
+	 * scope (relative name) or in the global scope only (absolute name),
+	 * then B must be a child of A : O(scope depth)
+	 */
+	const char *s = name.str;
+	const char *end = name.str + name.size;
+	int m = absolute ? 0 : from;
+	bool first = true;
+
+	while (s < end)
+	{
+		const char *e = s;
+		while (e < end && *e != ':') e++;
+		hash_t hash = span_hash(Span_t(s, e - s));
 
-		if (structs[i].hash == hash)
+		int found = -1;
+		for (int i = m; i >= 0; i = first ? modules[i].parent : -1)
 		{
-			t.hash = hash;
-			t.name = structs[i].name;
-			t.nameSpace = nameSpace;
-			t.baseName = t.name; // user type
-			t.type = ID_STRUCT + USER_BASE_SPACER_STRUCT;
-			return t;
+			Map<hash_t, int>::iterator it = modules[i].scopes.find(hash);
+			if (it != modules[i].scopes.end())
+			{
+				found = it->second;
+				break;
+			}
 		}
+		if (found < 0)
+			return -1;
+
+		m = found;
+		first = false;
+		s = e;
+		while (s < end && *s == ':') s++;
 	}
-	
-	error("unknown type: %x\n",hash);
 
-	return t;
+	return m;
+}
+
+// ----------------------------------------------------------------------------
+int Parser::find_type(const TypeNode_t& node, int from)
+{
+	/** built-in */
+	if (node.type >= 0)
+		return node.type;
+
+	/** scoped name : the type must be a member of the scope */
+	if (!node.scope.empty() || node.absolute)
+	{
+		int m = node.scope.empty() ? 0 :
+			find_scope(node.scope, node.absolute, from);
+		if (m < 0)
+			return -1;
+		Map<hash_t, int>::iterator it = modules[m].types.find(node.hash);
+		return it != modules[m].types.end() ? it->second : -1;
+	}
+
+	/** relative name : from the scope up to the global scope */
+	for (int i = from; i >= 0; i = modules[i].parent)
+	{
+		Map<hash_t, int>::iterator it = modules[i].types.find(node.hash);
+		if (it != modules[i].types.end())
+			return it->second;
+	}
+
+	return -1;
+}
+
+// ----------------------------------------------------------------------------
+void Parser::declare(hash_t hash, int id)
+{
+	modules[scope].types[hash] = id;
+	if (types.find(hash) == types.end())
+		types[hash] = id;
+}
+
+// ----------------------------------------------------------------------------
+int Parser::open_module(const Span_t& name)
+{
+	/** enter a (reopened) module, return the previous scope */
+	int previous = scope;
+	hash_t hash = span_hash(name);
+	Map<hash_t, int>::iterator it = modules[scope].scopes.find(hash);
+
+	if (it != modules[scope].scopes.end())
+	{
+		scope = it->second;
+	}
+	else
+	{
+		Module_t m;
+		m.hash = hash;
+		m.type = ID_MODULE + BASE_SPACER;
+		m.nameSpan = name;
+		m.parent = scope;
+		m.nameSpace = modules[scope].nameSpace;
+		if (m.nameSpace.size()) m.nameSpace += "::";
+		m.nameSpace += span2String(name);
+		if (!span_model) m.name = span2String(name);
+		modules.push_back(m);
+		scope = modules.size() - 1;
+		modules[previous].scopes[hash] = scope;
+	}
+
+	nameSpace = modules[scope].nameSpace;
+
+	return previous;
 }
 
 int Parser::getBase(const hash_t& hash)
@@ -382,13 +540,11 @@ int Parser::is_struct(const hash_t& hash, int& result)
 {
 	result = -1;
 
-	for (int i = 0; i < structs.size(); ++i)
+	Map<hash_t, int>::iterator it = types.find(hash);
+	if (it != types.end() && it->second >= USER_BASE_SPACER_STRUCT)
 	{
-		if (structs[i].hash == hash)
-		{
-			result = i+USER_BASE_SPACER_STRUCT;
-			return 1;
-		}
+		result = it->second;
+		return 1;
 	}
 	return 0;
 }
@@ -397,13 +553,26 @@ int Parser::is_typedef(const hash_t& hash, int& result)
 {
 	result = -1;
 
-	for (int i = 0; i < typedefs.size(); ++i)
+	Map<hash_t, int>::iterator it = types.find(hash);
+	if (it != types.end() && it->second >= USER_BASE_SPACER_TYPEDEF &&
+		it->second < USER_BASE_SPACER_STRUCT)
 	{
-		if (typedefs[i].hash == hash)
-		{
-			result = i+USER_BASE_SPACER_TYPEDEF;
-			return 1;
-		}
+		result = it->second;
+		return 1;
+	}
+	return 0;
+}
+
+int Parser::is_enum(const hash_t& hash, int& result)
+{
+	result = -1;
+
+	Map<hash_t, int>::iterator it = types.find(hash);
+	if (it != types.end() && it->second >= USER_BASE_SPACER_ENUM &&
+		it->second < USER_BASE_SPACER_TYPEDEF)
+	{
+		result = it->second;
+		return 1;
 	}
 	return 0;
 }
@@ -412,227 +581,3299 @@ int Parser::is_user_base(const hash_t& hash, int& result)
 {
 	if (is_typedef(hash, result)) return 1;
 	if (is_struct(hash, result)) return 1;
+	if (is_enum(hash, result)) return 1;
 	return 0;
 }
 
-inline
-String remove_namespace(const String& name, String& nameSpace)
+// ----------------------------------------------------------------------------
+Span_t Parser::scope_split(const Span_t& scoped, Span_t& scope)
 {
-	/** ::name1::name2 */
-	String s(name);
-	nameSpace = "";
-	s.replace("::", "/");
-	String_v mar = Explode(s, '/' );
-	
-	/** "0: name1 1: name2" */
-	if ( mar.size() >= 2 )
+	/** "::name1::name2::T" > scope: "name1::name2" name: "T" */
+	const char *b = scoped.str;
+	const char *e = scoped.str + scoped.size;
+	const char *n = e;
+
+	while (n > b && *(n - 1) != ':') n--;
+	scope = Span_t();
+
+	if (n > b)
 	{
-		nameSpace = mar[0];
-		s = String::basename(mar[1]);
+		const char *se = n;
+		while (se > b && *(se - 1) == ':') se--;
+		while (b < se && *b == ':') b++;
+		scope = Span_t(b, se - b);
 	}
 
-	return s;
+	return Span_t(n, e - n);
 }
 
-void Parser::parse_struct(const hash_t& type, const char* name, const char* body)
+// ----------------------------------------------------------------------------
+int Parser::skip_annotation(const char *src, const char *end, Span_t& name,
+	Span_t& value)
 {
-	String sbody;
-	char variable[4096];
-	Variable_t v;
-	Struct_t str;
-	str.hash = getHash(name);		// hash(name)
-	str.type = getBase(type);		// check built-in base
-	str.name = name;
-	str.nameSpace = nameSpace; // current namespace
-	const char* s = body;
+	/** @name or @name(value) */
+	const char *s = src;
+	s += skip_spaces(s);
+	name = Span_t();
+	value = Span_t();
 
-	minify(body, sbody);
+	if (s >= end || *s != '@')
+		return 0;
+	s++;
+	s += read_span(s, name);
 
-	MY_DEBUG("Storing struct : name: '" << name << "' body: '" << sbody << '\'');
+	const char *p = s + skip_spaces(s);
+	if (p < end && *p == '(')
+	{
+		int braces = 0;
+		for (s = p; s < end; s++)
+		{
+			if (*s == '(') braces++;
+			else if (*s == ')' && --braces == 0) { s++; break; }
+		}
 
-	s += skip_spaces(s);
-	while( *s )
+		/** value without '(' ')', spaces and quotes */
+		const char *v = p + 1;
+		const char *e = s - 1;
+		while (v < e && isspace(*v)) v++;
+		while (e > v && isspace(*(e - 1))) e--;
+		if (e - v >= 2 && *v == '"' && *(e - 1) == '"') { v++; e--; }
+		value = Span_t(v, e - v);
+	}
+
+	return s - src;
+}
+
+int Parser::annotation_int(const Span_t& name, const Span_t& value, int& result)
+{
+	/** @name(N) : digit or constant expression (folded), ie.: @id(BASE + 1) */
+	ConstValue_t v;
+	if ( value.empty() )
 	{
-		String fromNameSpace;
-		bool is_key = false;
-		s += read_block(s, variable, sizeof(variable), 0, ';');
-		s += skip_spaces(s);
-		MY_DEBUG("variable : '" << variable << "'");
-		
-		/***/
-		String_v mar = Explode(variable, ' ');
+		TRACE_ERROR("@" << name << " : missing value");
+		return 1;
+	}
+	if ( fold(value, scope, v) )
+		return 1;
+	if ( v.is_real )
+	{
+		TRACE_ERROR("@" << name << "(" << value << ") : not an integer");
+		return 1;
+	}
+	result = (int)v.integer;
+	return 0;
+}
 
-		if ( mar.size() >= 2 )
-		{
-			hash_t type;
-			String varName;
+int Parser::parse_annotations(const char *src, const char *end,
+	Annotation_t& annotation)
+{
+	const char *s = src;
+	Span_t name;
+	Span_t value;
+	int n;
 
-			if ( mar.size() >= 3 )
-			{
-				/**
-				 * mar[0] == key
-				 * mar[1] == type
-				 * mar[2] == field name
-				 */
-				if ( mar[0] == "@key" )
-				{
-					/* remove any namespace from type string */
-					mar[0] = remove_namespace( mar[0], fromNameSpace );
-					TRACE_DEBUG( "mar[0] >>> " << mar[0] );
-					type = getHash( mar[1] );
-					varName = mar[2];
-					is_key = true;
-				}
-				else
-				{
-					TRACE_ERROR("Unknwon type for variable: " << mar[0] );
-				}
-			}
-			else
+	while ( (n = skip_annotation(s, end, name, value)) > 0 )
+	{
+		s += n;
+
+		/** @key(FALSE), @optional(FALSE), ... */
+		const bool off = value.equals("FALSE") || value.equals("false");
+		int flag = ANN_NONE;
+
+		if ( name.equals("key") ) flag = ANN_KEY;
+		else if ( name.equals("optional") ) flag = ANN_OPTIONAL;
+		else if ( name.equals("external") ) flag = ANN_EXTERNAL;
+		else if ( name.equals("must_understand") ) flag = ANN_MUST_UNDERSTAND;
+		else if ( name.equals("final") ) flag = ANN_FINAL;
+		else if ( name.equals("appendable") ) flag = ANN_APPENDABLE;
+		else if ( name.equals("mutable") ) flag = ANN_MUTABLE;
+		else if ( name.equals("nested") ) flag = ANN_NESTED;
+		else if ( name.equals("topic") ) flag = ANN_TOPIC;
+		else if ( name.equals("cold") ) flag = ANN_COLD;
+		else if ( name.equals("align") )
+		{
+			int align = 0;
+			if ( annotation_int(name, value, align) )
+				continue;
+			if ( align <= 0 || (align & (align - 1)) )
 			{
-				/**
-				 * mar[0] == type
-				 * mar[1] == field name
-				 */
-				/* remove any namespace from type string */
-				mar[0] = remove_namespace( mar[0], fromNameSpace );
-				TRACE_DEBUG( "mar[0] >>> " << mar[0] );
-				type = getHash( mar[0] );
-				varName = mar[1];
+				TRACE_ERROR("@align(" << value << ") : not a power of 2");
+				continue;
 			}
+			flag = ANN_ALIGN;
+			annotation.align = align;
+		}
+		else if ( name.equals("id") )
+		{
+			if ( annotation_int(name, value, annotation.id) )
+				continue;
+			flag = ANN_ID;
+		}
+		else if ( name.equals("hashid") )
+		{
+			flag = ANN_HASHID;
+			annotation.hashid = value;
+		}
+		else if ( name.equals("position") )
+		{
+			if ( annotation_int(name, value, annotation.value) )
+				continue;
+			flag = ANN_POSITION;
+		}
+		else if ( name.equals("value") )
+		{
+			if ( annotation_int(name, value, annotation.value) )
+				continue;
+			flag = ANN_VALUE;
+		}
+		else if ( name.equals("bit_bound") )
+		{
+			if ( annotation_int(name, value, annotation.bit_bound) )
+				continue;
+			flag = ANN_BIT_BOUND;
+		}
+		else if ( name.equals("extensibility") )
+		{
+			if ( value.equals("FINAL") ) flag = ANN_FINAL;
+			else if ( value.equals("APPENDABLE") ) flag = ANN_APPENDABLE;
+			else if ( value.equals("MUTABLE") ) flag = ANN_MUTABLE;
+			else TRACE_ERROR("Unknown extensibility: " << value);
+			annotation.flags &= ~ANN_EXTENSIBILITY;
+		}
+		else if ( name.equals("autoid") )
+		{
+			if ( value.equals("HASH") ) annotation.flags |= ANN_AUTOID_HASH;
+			else annotation.flags &= ~ANN_AUTOID_HASH;
+			continue;
+		}
+		else
+		{
+			TRACE_DEBUG("Ignored annotation: @" << name);
+			continue;
+		}
 
-			v = parse_variable( type /* var type */,
-				name /* struct  name */,
-				varName,
-				fromNameSpace,
-				is_key
-			);
-			
-			str.fields.push_back( v );
+		if ( flag & ANN_EXTENSIBILITY )
+			annotation.flags &= ~ANN_EXTENSIBILITY;
+
+		if ( off )
+			annotation.flags &= ~flag;
+		else
+			annotation.flags |= flag;
+	}
+
+	return s - src;
+}
+
+/**
+ * MD5 of a member name, for @hashid / @autoid(HASH) :
+ * member id = first 4 bytes (little endian) & 0x0FFFFFFF (see XTypes 7.3.1.2.1.1)
+ */
+int Parser::member_hash(const Span_t& name)
+{
+	static const uint32_t k[64] = {
+		0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a,
+		0xa8304613, 0xfd469501, 0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be,
+		0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821, 0xf61e2562, 0xc040b340,
+		0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+		0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8,
+		0x676f02d9, 0x8d2a4c8a, 0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c,
+		0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70, 0x289b7ec6, 0xeaa127fa,
+		0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+		0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92,
+		0xffeff47d, 0x85845dd1, 0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1,
+		0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391 };
+	static const int r[16] = { 7, 12, 17, 22, 5, 9, 14, 20, 4, 11, 16, 23,
+		6, 10, 15, 21 };
+
+	uint32_t h[4] = { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476 };
+	const int size = name.size > 0 ? name.size : 0;
+	const int blocks = (size + 8) / 64 + 1;
+
+	for (int b = 0; b < blocks; b++)
+	{
+		/** message block : name, 0x80, 0, ..., length in bits (little endian) */
+		unsigned char chunk[64];
+		for (int i = 0; i < 64; i++)
+		{
+			const int pos = b * 64 + i;
+			if (pos < size) chunk[i] = (unsigned char)name.str[pos];
+			else if (pos == size) chunk[i] = 0x80;
+			else chunk[i] = 0;
+		}
+		if (b == blocks - 1)
+		{
+			const uint64_t bits = (uint64_t)size * 8;
+			for (int i = 0; i < 8; i++)
+				chunk[56 + i] = (unsigned char)(bits >> (8 * i));
+		}
+
+		uint32_t w[16];
+		for (int i = 0; i < 16; i++)
+			w[i] = chunk[i * 4] | (chunk[i * 4 + 1] << 8) |
+				(chunk[i * 4 + 2] << 16) | ((uint32_t)chunk[i * 4 + 3] << 24);
+
+		uint32_t a = h[0], bb = h[1], c = h[2], d = h[3];
+		for (int i = 0; i < 64; i++)
+		{
+			uint32_t f;
+			int g;
+			if (i < 16)      { f = (bb & c) | (~bb & d); g = i; }
+			else if (i < 32) { f = (d & bb) | (~d & c); g = (5 * i + 1) % 16; }
+			else if (i < 48) { f = bb ^ c ^ d; g = (3 * i + 5) % 16; }
+			else             { f = c ^ (bb | ~d); g = (7 * i) % 16; }
+
+			const uint32_t t = d;
+			const uint32_t x = a + f + k[i] + w[g];
+			const int rot = r[(i / 16) * 4 + i % 4];
+			d = c;
+			c = bb;
+			bb = bb + ((x << rot) | (x >> (32 - rot)));
+			a = t;
+		}
+		h[0] += a; h[1] += bb; h[2] += c; h[3] += d;
+	}
+
+	return (int)(h[0] & 0x0FFFFFFF);
+}
+
+// ----------------------------------------------------------------------------
+static int next_word(const char *src, const char *end, const char *word)
+{
+	/** size to skip if the next word of src is 'word', else 0 */
+	const char *s = src + Parser::skip_spaces(src);
+	int size = strlen(word);
+	if (s + size > end || strncmp(s, word, size) != 0 ||
+		isalnum(s[size]) || s[size] == '_')
+	{
+		return 0;
+	}
+	return (s + size) - src;
+}
+
+// ----------------------------------------------------------------------------
+int Parser::name_hash(const char *name, int size)
+{
+	/** FNV-1a : cheap enough to be emitted with the generated lookup(s) */
+	uint32_t h = 2166136261u;
+	for (int i = 0; i < size; ++i)
+	{
+		h ^= (unsigned char)name[i];
+		h *= 16777619u;
+	}
+	return (int)h;
+}
+
+// ----------------------------------------------------------------------------
+int Parser::read_type_name(const char *src, const char *end, Span_t& type,
+	hash_t& hash)
+{
+	/** 
+	 * read a type name as written, without any copy :
+	 * "::Mod1::T_Char", "long long", "unsigned short"
+	 */
+	const char *s = src;
+	int id = -1;
+	int n;
+	s += read_span(s, type);
+	hash = span_hash(type);
+
+	/** special case(s) : 'long long', 'unsigned short|long|long long' */
+	if (type.equals("unsigned"))
+	{
+		id = ID_UINT32;
+		if ((n = next_word(s, end, "short"))) { s += n; id = ID_UINT16; }
+		else if ((n = next_word(s, end, "long")))
+		{
+			s += n;
+			if ((n = next_word(s, end, "long"))) { s += n; id = ID_UINT64; }
+		}
+	}
+	else if (type.equals("long") && (n = next_word(s, end, "long")))
+	{
+		s += n;
+		id = ID_LONGLONG;
+	}
+
+	if (id >= 0)
+	{
+		type.size = s - type.str;
+		hash = __internal_hash[id].hash;
+	}
+
+	return s - src;
+}
+
+// ----------------------------------------------------------------------------
+int Parser::parse_bound(const char *src, const char *end, TypeNode_t& node)
+{
+	/** bound of a template : digit or constant expression (folded) */
+	const char *s = src;
+	s += skip_spaces(s);
+
+	const char *b = s;
+	bool digits = true;
+	int depth = 0;
+	while (s < end)
+	{
+		if (*s == '(') depth++;
+		else if (*s == ')') depth--;
+		else if (depth == 0 && (*s == ',' || *s == '>')) break;
+		if (!isdigit(*s) && !isspace(*s)) digits = false;
+		s++;
+	}
+	const char *e = s;
+	while (e > b && isspace(*(e - 1))) e--;
+
+	if (e == b)
+	{
+		TRACE_ERROR("Parser::parse_bound(): missing bound");
+	}
+	else if (digits)
+	{
+		node.size = atol(b);
+	}
+	else
+	{
+		ConstValue_t v;
+		node.sizeName = Span_t(b, e - b);
+		if (fold(node.sizeName, scope, v) == 0)
+		{
+			node.size = v.is_real ? (int)v.real : (int)v.integer;
+			if (node.size < 0 || v.is_real)
+				TRACE_ERROR("Bad bound: " << node.sizeName);
 		}
 	}
 
-	structs.push_back( str );
+	return s - src;
+}
+
+int Parser::parse_declarator(const char *src, const char *end, int scope,
+	Span_t& name, int& dims, int* array)
+{
+	/** name[N]* : field, typedef. N : digit or constant expression (folded) */
+	const char *s = src;
+	s += read_span(s, name);
+	s += skip_spaces(s);
+
+	dims = 0;
+	while ( s < end && *s == '[' )
+	{
+		const char *dim = ++s;
+		while ( s < end && *s != ']' ) s++;
+		ConstValue_t size;
+		fold( Span_t(dim, s - dim), scope, size );
+		if ( dims < MAX_ARRAY_DIM )
+			array[dims++] = (int)size.integer;
+		else
+			TRACE_ERROR("Too many array dimension: " << name);
+		if ( s < end ) s++;
+		s += skip_spaces(s);
+	}
+
+	return s - src;
+}
+
+const char* Parser::rfind_declarator(const char *begin, const char *end)
+{
+	/** start of the last declarator of [begin, end) ie.: "long A[4][N]" > "A[4][N]" */
+	const char *e = end;
+	for (;;)
+	{
+		while ( e > begin && isspace(*(e - 1)) ) e--;
+		if ( e == begin || *(e - 1) != ']' )
+			break;
+		while ( e > begin && *(e - 1) != '[' ) e--;
+		if ( e > begin ) e--;
+	}
+	return rfind_name(begin, e).str;
+}
+
+// ----------------------------------------------------------------------------
+int Parser::parse_type_spec(const char *src, const char *end, int& node)
+{
+	/**
+	 * recursive descent on a type spec :
+	 * type_spec : scoped_name
+	 *           | sequence '<' type_spec [',' bound] '>'
+	 *           | map '<' type_spec ',' type_spec [',' bound] '>'
+	 *           | string '<' bound '>'
+	 */
+	const char *s = src;
+	TypeNode_t n;
+	Span_t type;
+	int result;
+
+	s += read_type_name(s, end, type, n.hash);
+	n.name = scope_split(type, n.scope);
+	n.absolute = type.size > 0 && type.str[0] == ':';
+	if (!n.scope.empty() || n.absolute) n.hash = span_hash(n.name);
+	if (is_builtin_type(n.hash, result)) n.type = result;
+
+	node = nodes.size();
+	nodes.push_back(n);
+
+	const char *p = s + skip_spaces(s);
+	if (p < end && *p == '<')
+	{
+		s = p + 1;
+		if (n.type == ID_SEQUENCE + TYPE_SPACER)
+		{
+			int child;
+			s += parse_type_spec(s, end, child);
+			nodes[node].child = child;
+			s += skip_spaces(s);
+			if (s < end && *s == ',')
+			{
+				s++;
+				s += parse_bound(s, end, nodes[node]);
+			}
+		}
+		else if (n.type == ID_MAP + TYPE_SPACER)
+		{
+			int key, value = -1;
+			s += parse_type_spec(s, end, key);
+			s += skip_spaces(s);
+			if (s < end && *s == ',')
+			{
+				s++;
+				s += parse_type_spec(s, end, value);
+			}
+			else
+			{
+				TRACE_ERROR("Parser::parse_type_spec(): map without value type");
+			}
+			nodes[node].child = key;
+			nodes[node].mapped = value;
+			s += skip_spaces(s);
+			if (s < end && *s == ',')
+			{
+				s++;
+				s += parse_bound(s, end, nodes[node]);
+			}
+		}
+		else
+		{
+			s += parse_bound(s, end, nodes[node]);
+		}
+
+		s += skip_spaces(s);
+		if (s < end && *s == '>') s++;
+		else TRACE_ERROR("Parser::parse_type_spec(): expecting '>' for " << type);
+	}
+
+	return s - src;
+}
+
+// ----------------------------------------------------------------------------
+Typedef_t Parser::node2Type(int node, int scope)
+{
+	Typedef_t t;
+
+	if (node < 0 || node >= nodes.size())
+		return t;
+
+	const TypeNode_t& n = nodes[node];
+
+	if (n.type == ID_SEQUENCE + TYPE_SPACER)
+	{
+		/** element type, keep the sequence info (type + size) */
+		if (n.child >= 0) t = node2Type(n.child, scope);
+		t.type = n.type;
+		t.size = n.size >= 0 ? n.size : 0;
+	}
+	else
+	{
+		int id = find_type(n, scope);
+		if (id < 0)
+			TRACE_ERROR("unknown type: " << n.scope << "::" << n.name);
+		else
+			t = id2Type(id);
+		if (n.size >= 0) t.size = n.size; // string<N>
+	}
+	t.node = node;
+
+	return t;
+}
+
+void Parser::parse_struct(const hash_t& type, const Span_t& name, 
+	const Span_t& body, const Annotation_t& annotation, int disc, int base)
+{
+	Struct_t str;
+	str.hash = span_hash(name);		// hash(name)
+	str.type = getBase(type);		// check built-in base
+	if ( !span_model )
+	{
+		str.name = span2String(name);
+	}
+	str.nameSpace = nameSpace; // current namespace
+	str.scope = scope;
+	str.nameSpan = name;
+	str.body = body;
+	str.flags = annotation.flags & ~(ANN_ID | ANN_HASHID | ANN_COLD);
+	if ( annotation.flags & ANN_ALIGN )
+		str.aligned = annotation.align;
+	str.disc = disc;
+	str.base = base;
+
+	MY_DEBUG("Storing struct : name: '" << name << "' body size: " << body.size );
+
+	/** lazy : the body is parsed the first time the struct is required */
+	if ( lazy )
+		str.lazy = true;
+	else
+		parse_fields( str );
+
+	/** defined after a forward declaration : same slot */
+	Map<hash_t, int>::iterator it = modules[scope].types.find(str.hash);
+	if ( it != modules[scope].types.end() && 
+		it->second >= USER_BASE_SPACER_STRUCT &&
+		structs[it->second - USER_BASE_SPACER_STRUCT].forward )
+	{
+		structs[it->second - USER_BASE_SPACER_STRUCT] = str;
+		return;
+	}
+
+	structs.push_back( str );
+	declare( str.hash, USER_BASE_SPACER_STRUCT + structs.size() - 1 );
+}
+
+void Parser::parse_enum(const hash_t& type, const Span_t& name,
+	const Span_t& body, const Annotation_t& annotation)
+{
+	Enum_t e;
+	e.hash = span_hash(name);
+	e.type = getBase(type);		// enum or bitmask
+	const bool bitmask = e.type == ID_BITMASK + BASE_SPACER;
+	const int max_bits = bitmask ? 64 : 32;
+	if ( !span_model )
+	{
+		e.name = span2String(name);
+	}
+	e.nameSpace = nameSpace;
+	e.scope = scope;
+	e.nameSpan = name;
+	e.flags = annotation.flags;
+	if ( annotation.flags & ANN_BIT_BOUND )
+		e.bit_bound = annotation.bit_bound;
+	if ( e.bit_bound < 1 || e.bit_bound > max_bits )
+	{
+		TRACE_ERROR("Bad @bit_bound(" << e.bit_bound << ") for " << name);
+		e.bit_bound = 32;
+	}
+	e.bytes = e.bit_bound <= 8 ? 1 : e.bit_bound <= 16 ? 2 : 
+		e.bit_bound <= 32 ? 4 : 8;
+
+	/** [@value(N)|@position(N)] NAME [, ...]* */
+	const char *s = body.str;
+	const char *end = body.str + body.size;
+	int next = 0;
+	while ( s < end )
+	{
+		Annotation_t a;
+		s += parse_annotations(s, end, a);
+		s += skip_spaces(s);
+		if ( s >= end ) break;
+
+		Enumerator_t v;
+		s += read_span(s, v.nameSpan);
+		if ( v.nameSpan.empty() )
+		{
+			TRACE_ERROR("Bad enumerator in " << name << ": '" << *s << "'");
+			s++;
+			continue;
+		}
+		v.hash = span_hash(v.nameSpan);
+		if ( !span_model )
+			v.name = span2String(v.nameSpan);
+		v.value = (a.flags & (ANN_VALUE | ANN_POSITION)) ? a.value : next;
+		next = v.value + 1;
+
+		if ( bitmask ? (v.value < 0 || v.value >= e.bit_bound) :
+			(e.bit_bound < 32 && (unsigned int)v.value >= (1u << e.bit_bound)) )
+			TRACE_WARNING("Enumerator " << v.nameSpan << " out of @bit_bound(" <<
+				e.bit_bound << ")");
+
+		if ( e.values.size() == 0 || v.value < e.min ) e.min = v.value;
+		if ( e.values.size() == 0 || v.value > e.max ) e.max = v.value;
+		e.values.push_back( v );
+
+		s += skip_spaces(s);
+		if ( s < end && *s == ',' ) s++;
+	}
+
+	MY_DEBUG("Storing enum : " << name << " (" << e.values.size() << " value(s))");
+
+	/** value > enumerator, name > enumerator */
+	int_v keys;
+	int j;
+	for ( j = 0; j < e.values.size(); ++j )
+		keys.push_back( e.values[j].value );
+	build_table( e.byValue, keys );
+
+	e.contiguous = e.byValue.seed == 0;
+	for ( j = 0; j < e.byValue.index.size() && e.contiguous; ++j )
+		e.contiguous = e.byValue.index[j] >= 0;
+
+	keys.clear();
+	for ( j = 0; j < e.values.size(); ++j )
+		keys.push_back( name_hash(e.values[j].nameSpan.str, e.values[j].nameSpan.size) );
+	build_table( e.byName, keys );
+
+	enums.push_back( e );
+	declare( e.hash, USER_BASE_SPACER_ENUM + enums.size() - 1 );
+}
+
+int Parser::enum_value(int i, const char *name, int size, int& value)
+{
+	/** enumerator name > value, 0 if unknown */
+	const Enum_t& e = enums[i];
+	int k = e.byName.find( name_hash(name, size) );
+	if ( k < 0 || e.values[k].nameSpan.size != size ||
+		strncmp(e.values[k].nameSpan.str, name, size) )
+		return 0;
+	value = e.values[k].value;
+	return 1;
+}
+
+void Parser::parse_bitset(Struct_t& str)
+{
+	/**
+	 * bitfield<N[, type]> [name [, name]*] ; packed from bit 0,
+	 * an anonymous bitfield only skips N bit(s)
+	 */
+	const char* s = str.body.str;
+	const char* end = str.body.str + str.body.size;
+
+	str.bits = 0;
+	s += skip_spaces(s);
+	while ( s < end )
+	{
+		Annotation_t annotation;
+		s += parse_annotations(s, end, annotation);
+		s += skip_spaces(s);
+		if ( s >= end ) break;
+		if ( *s == ';' ) { s++; s += skip_spaces(s); continue; }
+
+		if ( strncmp(s, "bitfield", 8) )
+		{
+			TRACE_ERROR("bitset " << str.nameSpan << ": bitfield<N> expected");
+			while ( s < end && *s != ';' ) s++;
+			continue;
+		}
+		s += 8;
+		s += expect_symbol(s, '<');
+
+		/** width : digit or constant expression (folded), ie.: bitfield<N * 2> */
+		TypeNode_t width;
+		s += parse_bound(s, end, width);
+		const int bits = width.size;
+		s += skip_spaces(s);
+		if ( bits < 1 || bits > 64 )
+		{
+			TRACE_ERROR("bitset " << str.nameSpan << ": bad bitfield width " <<
+				bits << " (1 to 64)");
+			while ( s < end && *s != ';' ) s++;
+			continue;
+		}
+
+		/** holder type : given, else the smallest one (see XTypes 7.2.2.4.4.4.8) */
+		int node = -1;
+		if ( *s == ',' )
+		{
+			s++;
+			const char *type = s + skip_spaces(s);
+			while ( s < end && *s != '>' ) s++;
+			parse_type_spec(type, s, node);
+		}
+		else
+		{
+			TypeNode_t n;
+			n.type = TYPE_SPACER + (bits == 1 ? ID_BOOLEAN : bits <= 8 ? ID_OCTET :
+				bits <= 16 ? ID_UINT16 : bits <= 32 ? ID_UINT32 : ID_UINT64);
+			nodes.push_back( n );
+			node = nodes.size() - 1;
+		}
+		s += expect_symbol(s, '>');
+		s += skip_spaces(s);
+
+		/** name(s), none : padding */
+		if ( *s == ';' )
+			str.bits += bits;
+		while ( s < end && *s != ';' )
+		{
+			Span_t varName;
+			s += read_span(s, varName);
+			s += skip_spaces(s);
+
+			Variable_t v = parse_variable( node, str.name, varName,
+				nodes[node].scope, annotation );
+			v.bits = bits;
+			v.shift = str.bits;
+			str.bits += bits;
+			str.fields.push_back( v );
+
+			if ( s < end && *s == ',' ) s++;
+		}
+		if ( s < end ) s++;
+		s += skip_spaces(s);
+	}
+
+	if ( str.bits > 64 )
+		TRACE_ERROR("bitset " << str.nameSpan << ": " << str.bits << " bits > 64");
+}
+
+void Parser::parse_fields(Struct_t& str)
+{
+	const char* s = str.body.str;
+	const char* end = str.body.str + str.body.size; /** body is not null terminated */
+
+	if ( str.type == ID_BITSET + BASE_SPACER )
+	{
+		parse_bitset( str );
+		return;
+	}
+
+	/**
+	 * fields are read straight from the source, no copy :
+	 * [@annotation[(...)]]* type declarator [, declarator]* ;
+	 * type       : name, ::scoped::name, long long, template<...>
+	 * declarator : name[N]*
+	 */
+	s += skip_spaces(s);
+	int next_id = 0; // @autoid(SEQUENTIAL)
+	while( s < end )
+	{
+		Annotation_t annotation;
+		Span_t typeSpan;
+		int node;
+
+		s += parse_annotations(s, end, annotation);
+		s += skip_spaces(s);
+		if ( s >= end ) break;
+
+		if ( *s == ';' ) { s++; s += skip_spaces(s); continue; }
+
+		/** union : case X: [case Y:]* | default: */
+		if ( str.disc >= 0 &&
+			((!strncmp(s, "case", 4) && !isalnum(s[4]) && s[4] != '_') ||
+			(!strncmp(s, "default", 7) && !isalnum(s[7]) && s[7] != '_')) )
+		{
+			const bool is_default = *s == 'd';
+			s += is_default ? 7 : 4;
+			s += skip_spaces(s);
+
+			Span_t label(s, 0);
+			while ( s < end )
+			{
+				if ( *s == ':' && s + 1 < end && s[1] == ':' ) { s += 2; continue; } // scoped name
+				if ( *s == ':' ) break;
+				if ( *s == '\'' ) // 'c', '\n'
+				{
+					s++;
+					if ( s < end && *s == '\\' ) s++;
+					if ( s < end ) s++;
+					if ( s < end && *s == '\'' ) s++;
+					continue;
+				}
+				s++;
+			}
+			label.size = s - label.str;
+			while ( label.size > 0 && isspace(label.str[label.size - 1]) ) label.size--;
+			if ( s < end ) s++;
+
+			if ( is_default )
+			{
+				str.branch_default = str.fields.size();
+			}
+			else
+			{
+				str.labels.push_back( label );
+				str.branches.push_back( str.fields.size() );
+			}
+			s += skip_spaces(s);
+			continue;
+		}
+
+		typeSpan.str = s;
+		s += parse_type_spec(s, end, node);
+		typeSpan.size = s - typeSpan.str;
+		TRACE_DEBUG( "type >>> " << typeSpan );
+
+		/** declarator(s) */
+		while ( s < end )
+		{
+			Span_t varName;
+			int dims;
+			int array[MAX_ARRAY_DIM];
+			s += parse_declarator(s, end, str.scope, varName, dims, array);
+
+			Variable_t v = parse_variable( node /* var type */,
+				str.name /* struct  name */,
+				varName,
+				nodes[node].scope,
+				annotation
+			);
+			v.typeSpan = typeSpan;
+
+			/** member id : @id(N), @hashid, @autoid(HASH), else previous + 1 */
+			if ( annotation.flags & ANN_ID )
+				v.id = annotation.id;
+			else if ( (annotation.flags & ANN_HASHID) || (str.flags & ANN_AUTOID_HASH) )
+				v.id = member_hash(annotation.hashid.empty() ? varName : annotation.hashid);
+			else
+				v.id = next_id;
+			next_id = v.id + 1;
+			annotation.flags &= ~ANN_ID; // only the first declarator
+
+			if ( v.flags & ANN_OPTIONAL )
+			{
+				v.bit = str.optionals.size();
+				str.optionals.push_back( str.fields.size() );
+			}
+
+			/** array : name[N][M] */
+			v.dims = dims;
+			for ( int d = 0; d < dims; ++d )
+				v.array[d] = array[d];
+
+			str.fields.push_back( v );
+
+			if ( s < end && *s == ',' ) { s++; continue; }
+			break;
+		}
+
+		/** end of the declaration */
+		while ( s < end && *s != ';' ) s++;
+		if ( s < end ) s++;
+		s += skip_spaces(s);
+	}
+}
+
+void Parser::parse_typedef(const Span_t& body)
+{
+	/**
+	 * typedef type_spec name;
+	 * ie.:
+	 * typedef T_Char T_Char2;
+	 * typedef sequence<T_Char, 50> T_SmallString;
+	 * typedef sequence<sequence<long, 4>, 8> T_Matrix;
+	 * typedef long T_Vec[4];
+	 */
+	TRACE_DEBUG( "Typedef: '" << body << "'" );
+	Typedef_t typeDef;
+	typeDef.scope = scope;
+	typeDef.body = body;
+
+	if ( lazy )
+	{
+		/** only the name : the body is parsed when the typedef is required */
+		const char *end = body.str + body.size;
+		int dims;
+		int array[MAX_ARRAY_DIM];
+		typeDef.lazy = true;
+		parse_declarator( rfind_declarator(body.str, end), end, scope,
+			typeDef.nameSpan, dims, array );
+		typeDef.hash = span_hash( typeDef.nameSpan );
+	}
+	else
+	{
+		parse_typedef_body( typeDef );
+	}
+
+	if ( !span_model )
+	{
+		typeDef.name = span2String( typeDef.nameSpan );
+		typeDef.nameSpace = nameSpace;
+	}
+
+	TRACE_DEBUG("Storing typedef > newTypeName: '" << typeDef.nameSpan << 
+		"' size: " << typeDef.size );
+	typedefs.push_back( typeDef );
+	declare( typeDef.hash, USER_BASE_SPACER_TYPEDEF + typedefs.size() - 1 );
+}
+
+void Parser::parse_typedef_body(Typedef_t& typeDef)
+{
+	const char *s = typeDef.body.str;
+	const char *end = typeDef.body.str + typeDef.body.size;
+	Span_t name;
+	int node;
+
+	s += parse_type_spec(s, end, node);
+	s += parse_declarator(s, end, typeDef.scope, name, typeDef.dims, typeDef.array);
+
+	const TypeNode_t& n = nodes[node];
+	typeDef.hash = span_hash( name );
+	typeDef.nameSpan = name;
+	typeDef.node = node;
+	typeDef.size = n.size;
+
+	if ( n.type == ID_SEQUENCE + TYPE_SPACER )
+	{
+		/**
+		 * a sequence can be :
+		 * sequence<type> name
+		 * sequence<type,size> name
+		 * sequence<sequence<type,size>,size> name > no base name, see node
+		 */
+		typeDef.type = n.type;
+		typeDef.size = n.size >= 0 ? n.size : 0;
+		if ( n.child >= 0 && nodes[n.child].child < 0 &&
+			nodes[n.child].type != ID_SEQUENCE + TYPE_SPACER )
+		{
+			typeDef.baseHash = nodes[n.child].hash;
+			if ( !span_model )
+				typeDef.baseName = span2String( nodes[n.child].name );
+		}
+	}
+	else
+	{
+		/** base type is resolved later, see resolve_typedef() */
+		typeDef.type = -1;
+		typeDef.baseHash = n.hash;
+	}
+}
+
+// ----------------------------------------------------------------------------
+int Parser::resolve_typedef(int i)
+{
+	Typedef_t& td = typedefs[i];
+
+	if ( td.type >= 0 || td.lazy || td.node < 0 )
+		return 0; // sequence, already resolved, not required or recursive
+
+	int result = find_type( nodes[td.node], td.scope );
+	if ( result < 0 )
+	{
+		TRACE_ERROR("Unknown type: " << nodes[td.node].name << 
+			" for typedef " << td.nameSpan );
+		return 1;
+	}
+
+	td.type = result;
+	if ( !span_model )
+		td.baseName = type2Name(result);
+
+	return 0;
+}
+
+int Parser::typedef_cycles(int i, int_v& state, int_v& path)
+{
+	/**
+	 * depth first on the typedef(s) a typedef uses (a struct ends the walk) :
+	 * state 1 : on the path, 2 : done. a typedef of a cycle is left
+	 * unresolved, without type tree, so every walk (layout, class, size)
+	 * stops on it. ie.: typedef B A; typedef A B;
+	 * return the count of error(s)
+	 */
+	if ( state[i] )
+		return 0;
+
+	Typedef_t& td = typedefs[i];
+	if ( td.lazy )
+	{
+		state[i] = 2;
+		return 0;
+	}
+
+	int errors = 0;
+	int_v refs;
+	type_refs( td.node, td.scope, refs );
+	state[i] = 1;
+	path.push_back( i );
+	for ( int r = 0; r < refs.size(); ++r )
+	{
+		if ( refs[r] < USER_BASE_SPACER_TYPEDEF || refs[r] >= USER_BASE_SPACER_STRUCT )
+			continue;
+		int j = refs[r] - USER_BASE_SPACER_TYPEDEF;
+		if ( state[j] != 1 )
+		{
+			errors += typedef_cycles( j, state, path );
+			continue;
+		}
+
+		/** back to j : the typedef(s) of the path from j form a cycle */
+		int k = path.size();
+		while ( path[--k] != j ) {}
+		for ( ; k < path.size(); ++k )
+		{
+			Typedef_t& c = typedefs[path[k]];
+			if ( c.node < 0 )
+				continue; // already reported
+			TRACE_ERROR("recursive typedef: " << c.nameSpan);
+			c.type = -1;
+			c.node = -1;
+			errors++;
+		}
+	}
+	path.pop_back();
+	state[i] = 2;
+
+	return errors;
+}
+
+// ----------------------------------------------------------------------------
+int Parser::resolve_variable(Variable_t& v)
+{
+	v.type = node2Type( v.type.node, v.scope );
+
+	if ( v.type.hash == 0 )
+	{
+		TRACE_ERROR("Unknown type for variable: " << v.nameSpan );
+		return 1;
+	}
+
+	return 0;
+}
+
+// ----------------------------------------------------------------------------
+int Parser::resolve_struct(int i)
+{
+	Struct_t& str = structs[i];
+	int errors = 0;
+
+	if ( str.forward )
+	{
+		TRACE_ERROR("struct " << str.nameSpan << " is declared but never defined");
+		return 1;
+	}
+	if ( str.lazy )
+		return 0; // not required
+
+	for ( int j = 0; j < str.fields.size(); ++j )
+	{
+		errors += resolve_variable( str.fields[j] );
+	}
+
+	return errors;
+}
+
+// ----------------------------------------------------------------------------
+struct ResolveContext_t
+{
+	Parser* parser;
+	int_v* errors;
+};
+
+static void resolve_struct_fn(void* ctx, int i)
+{
+	ResolveContext_t* r = (ResolveContext_t*)ctx;
+	(*r->errors)[i] = r->parser->resolve_struct(i);
+}
+
+int Parser::resolve()
+{
+	/**
+	 * second pass : every name is known now (types defined later and forward
+	 * declarations), resolve them in dependency order :
+	 * typedef base types, then typedef chains (memoized), then fields.
+	 */
+	int errors = 0;
+	int i;
+
+	resolved.clear();
+	resolving.clear();
+	resolved.resize( typedefs.size() );
+	resolving.resize( typedefs.size(), 0 );
+
+	for ( i = 0; i < typedefs.size(); ++i )
+		errors += resolve_typedef( i );
+
+	int_v state, path;
+	state.resize( typedefs.size(), 0 );
+	for ( i = 0; i < typedefs.size(); ++i )
+		errors += typedef_cycles( i, state, path );
+
+	for ( i = 0; i < typedefs.size(); ++i )
+		id2Type( USER_BASE_SPACER_TYPEDEF + i );
+
+	/** typedefs are done : structs only read them, one struct per worker */
+	int_v struct_errors;
+	struct_errors.resize( structs.size(), 0 );
+	ResolveContext_t ctx = { this, &struct_errors };
+	parallel( structs.size(), resolve_struct_fn, &ctx, threads );
+	for ( i = 0; i < structs.size(); ++i )
+		errors += struct_errors[i];
+
+	/** global variable(s) only : the fields are resolved with their struct */
+	for ( i = 0; i < variables.size(); ++i )
+		errors += resolve_variable( variables[i] );
+
+	for ( i = 0; i < interfaces.size(); ++i )
+	{
+		for ( int j = 0; j < interfaces[i].operations.size(); ++j )
+		{
+			Operation_t& op = interfaces[i].operations[j];
+			if ( op.result.type.node >= 0 )
+				errors += resolve_variable( op.result );
+			for ( int k = 0; k < op.params.size(); ++k )
+				errors += resolve_variable( op.params[k] );
+		}
+	}
+
+	build_graph();
+
+	for ( i = 0; i < structs.size(); ++i )
+		for ( int e = 0; e < ENCODINGS; ++e )
+			structs[i].xcdr_done[e] = 0; // see xcdr_struct()
+
+	/** inheritance, layout, classes : dependencies first, then the key paths */
+	for ( i = 0; i < graph.order.size(); ++i )
+	{
+		int v = graph.order[i];
+		if ( v < structs.size() )
+		{
+			inherit( v );
+			layout_struct( v );
+			classify( v );
+			serialized_size( v );
+		}
+		else if ( v < structs.size() + typedefs.size() )
+		{
+			Typedef_t& td = typedefs[v - structs.size()];
+			td.classes = typedef_class( td );
+		}
+	}
+	for ( i = 0; i < structs.size(); ++i )
+	{
+		resolve_keys( i );
+		member_table( i );
+		case_table( i );
+	}
+
+	MY_DEBUG("resolve() : " << errors << " error(s), " << 
+		graph.levels.size() << " level(s)");
+
+	return errors;
+}
+
+// ----------------------------------------------------------------------------
+int Parser::graph_id(int vertex)
+{
+	/** vertex > type id (see is_user_base) */
+	if (vertex < structs.size())
+		return USER_BASE_SPACER_STRUCT + vertex;
+	vertex -= structs.size();
+	if (vertex < typedefs.size())
+		return USER_BASE_SPACER_TYPEDEF + vertex;
+	return USER_BASE_SPACER_ENUM + vertex - typedefs.size();
+}
+
+int Parser::graph_vertex(int id)
+{
+	/** type id > vertex, -1 for a built-in type */
+	if (id >= USER_BASE_SPACER_STRUCT)
+		return id - USER_BASE_SPACER_STRUCT;
+	if (id >= USER_BASE_SPACER_TYPEDEF)
+		return structs.size() + id - USER_BASE_SPACER_TYPEDEF;
+	if (id >= USER_BASE_SPACER_ENUM)
+		return structs.size() + typedefs.size() + id - USER_BASE_SPACER_ENUM;
+	return -1;
+}
+
+// ----------------------------------------------------------------------------
+void Parser::type_refs(int node, int scope, int_v& ids)
+{
+	/** every user type of a type tree, ie.: sequence<A> > A */
+	for (; node >= 0; node = nodes[node].child)
+	{
+		if (nodes[node].mapped >= 0)
+			type_refs(nodes[node].mapped, scope, ids); // map value
+		if (nodes[node].type >= 0)
+			continue; // built-in
+
+		int id = find_type(nodes[node], scope);
+		if (id < USER_BASE_SPACER_ENUM)
+			continue;
+
+		int i;
+		for (i = 0; i < ids.size() && ids[i] != id; ++i) {}
+		if (i == ids.size())
+			ids.push_back(id);
+	}
+}
+
+void Parser::graph_edges(int vertex, int node, int scope)
+{
+	int_v ids;
+	type_refs(node, scope, ids);
+
+	int_v& edges = graph.edges[vertex];
+	for (int i = 0; i < ids.size(); ++i)
+	{
+		int to = graph_vertex(ids[i]);
+		int j;
+		for (j = 0; j < edges.size() && edges[j] != to; ++j) {}
+		if (j == edges.size())
+			edges.push_back(to);
+	}
+}
+
+// ----------------------------------------------------------------------------
+int Parser::require(int id)
+{
+	/**
+	 * parse the body of a lazy type, and of every type it uses.
+	 * return the count of parsed body(ies)
+	 */
+	int_v stack;
+	int count = 0;
+	int previous = scope;
+
+	stack.push_back(id);
+	while (stack.size())
+	{
+		id = stack[stack.size() - 1];
+		stack.pop_back();
+
+		int_v refs;
+		if (id >= USER_BASE_SPACER_STRUCT)
+		{
+			Struct_t& str = structs[id - USER_BASE_SPACER_STRUCT];
+			if (!str.lazy)
+				continue;
+			str.lazy = false;
+			scope = str.scope;
+			parse_fields(str);
+			for (int j = 0; j < str.fields.size(); ++j)
+				type_refs(str.fields[j].type.node, str.scope, refs);
+			type_refs(str.disc, str.scope, refs);
+			type_refs(str.base, str.scope, refs);
+		}
+		else if (id >= USER_BASE_SPACER_TYPEDEF)
+		{
+			Typedef_t& td = typedefs[id - USER_BASE_SPACER_TYPEDEF];
+			if (!td.lazy)
+				continue;
+			td.lazy = false;
+			scope = td.scope;
+			parse_typedef_body(td);
+			type_refs(td.node, td.scope, refs);
+		}
+		else
+		{
+			continue;
+		}
+
+		count++;
+		for (int j = 0; j < refs.size(); ++j)
+			stack.push_back(refs[j]);
+	}
+
+	scope = previous;
+
+	return count;
+}
+
+// ----------------------------------------------------------------------------
+void Parser::build_graph()
+{
+	int count = structs.size() + typedefs.size() + enums.size();
+	int i, j;
+
+	graph = TypeGraph_t();
+	graph.edges.resize(count);
+	graph.level.resize(count, 0);
+	graph.component.resize(count, -1);
+	graph.used.resize(count, 1);
+
+	for (i = 0; i < structs.size(); ++i)
+	{
+		for (j = 0; j < structs[i].fields.size(); ++j)
+		{
+			const Variable_t& v = structs[i].fields[j];
+			graph_edges(i, v.type.node, v.scope);
+		}
+		graph_edges(i, structs[i].disc, structs[i].scope); // union
+		graph_edges(i, structs[i].base, structs[i].scope); // inheritance
+	}
+	for (i = 0; i < typedefs.size(); ++i)
+	{
+		graph_edges(structs.size() + i, typedefs[i].node, typedefs[i].scope);
+	}
+
+	/** a lazy type that was never required is not used */
+	for (i = 0; i < count; ++i)
+	{
+		int id = graph_id(i);
+		if (id >= USER_BASE_SPACER_STRUCT)
+			graph.used[i] = !structs[id - USER_BASE_SPACER_STRUCT].lazy;
+		else if (id >= USER_BASE_SPACER_TYPEDEF)
+			graph.used[i] = !typedefs[id - USER_BASE_SPACER_TYPEDEF].lazy;
+	}
+
+	/**
+	 * Tarjan (iterative) : a component is complete once all the components
+	 * it depends on are complete, so they come out dependencies first and
+	 * the level of a component is 1 + the max level of its dependencies.
+	 */
+	int_v index, low, on_stack, stack, call, next, component_level;
+	int counter = 0;
+	index.resize(count, -1);
+	low.resize(count, 0);
+	on_stack.resize(count, 0);
+
+	for (i = 0; i < count; ++i)
+	{
+		if (index[i] >= 0)
+			continue;
+
+		index[i] = low[i] = counter++;
+		stack.push_back(i); on_stack[i] = 1;
+		call.push_back(i); next.push_back(0);
+
+		while (call.size())
+		{
+			int v = call[call.size() - 1];
+			int& e = next[next.size() - 1];
+
+			if (e < graph.edges[v].size())
+			{
+				int w = graph.edges[v][e++];
+				if (index[w] < 0)
+				{
+					index[w] = low[w] = counter++;
+					stack.push_back(w); on_stack[w] = 1;
+					call.push_back(w); next.push_back(0);
+				}
+				else if (on_stack[w] && index[w] < low[v])
+				{
+					low[v] = index[w];
+				}
+				continue;
+			}
+
+			call.pop_back(); next.pop_back();
+			if (call.size())
+			{
+				int u = call[call.size() - 1];
+				if (low[v] < low[u]) low[u] = low[v];
+			}
+			if (low[v] != index[v])
+				continue;
+
+			/** v is the root of a component */
+			int c = graph.components.size();
+			int level = 0;
+			graph.components.push_back(int_v());
+			int w;
+			do
+			{
+				w = stack[stack.size() - 1];
+				stack.pop_back(); on_stack[w] = 0;
+				graph.component[w] = c;
+				graph.components[c].push_back(w);
+			} while (w != v);
+
+			const int_v& members = graph.components[c];
+			for (j = 0; j < members.size(); ++j)
+			{
+				const int_v& edges = graph.edges[members[j]];
+				for (int k = 0; k < edges.size(); ++k)
+				{
+					int d = graph.component[edges[k]];
+					if (d != c && component_level[d] + 1 > level)
+						level = component_level[d] + 1;
+				}
+			}
+			component_level.push_back(level);
+
+			if (graph.levels.size() <= level)
+				graph.levels.resize(level + 1);
+			for (j = 0; j < members.size(); ++j)
+			{
+				graph.level[members[j]] = level;
+				graph.levels[level].push_back(members[j]);
+				graph.order.push_back(members[j]);
+			}
+		}
+	}
+}
+
+// ----------------------------------------------------------------------------
+int Parser::prune(const int_v& roots)
+{
+	/** depth first walk from the roots, return the count of used type(s) */
+	int_v stack;
+	int count = 0;
+	int i;
+
+	/** lazy : the roots (and what they use) may not be parsed yet */
+	int loaded = 0;
+	for (i = 0; i < roots.size(); ++i)
+		loaded += require(roots[i]);
+	if (loaded)
+		resolve();
+
+	for (i = 0; i < graph.used.size(); ++i)
+		graph.used[i] = 0;
+
+	for (i = 0; i < roots.size(); ++i)
+	{
+		int v = graph_vertex(roots[i]);
+		if (v >= 0 && v < graph.used.size() && !graph.used[v])
+		{
+			graph.used[v] = 1;
+			stack.push_back(v);
+		}
+	}
+
+	while (stack.size())
+	{
+		int v = stack[stack.size() - 1];
+		stack.pop_back();
+		count++;
+
+		const int_v& edges = graph.edges[v];
+		for (i = 0; i < edges.size(); ++i)
+		{
+			if (!graph.used[edges[i]])
+			{
+				graph.used[edges[i]] = 1;
+				stack.push_back(edges[i]);
+			}
+		}
+	}
+
+	MY_DEBUG("prune() : " << count << " / " << graph.used.size() << " type(s) used");
+
+	return count;
+}
+
+// ----------------------------------------------------------------------------
+int_v Parser::topics()
+{
+	/** topic types : #pragma keylist, struct with a key field */
+	int_v roots;
+
+	for (int i = 0; i < keylists.size(); ++i)
+	{
+		int id = find_keylist(keylists[i]);
+		if (id >= USER_BASE_SPACER_STRUCT)
+			roots.push_back(id);
+	}
+
+	for (int i = 0; i < structs.size(); ++i)
+	{
+		if (keyed(i))
+			roots.push_back(USER_BASE_SPACER_STRUCT + i);
+	}
+
+	/** request and reply types of the operations */
+	for (int i = 0; i < interfaces.size(); ++i)
+	{
+		for (int j = 0; j < interfaces[i].operations.size(); ++j)
+		{
+			const Operation_t& op = interfaces[i].operations[j];
+			if (op.result.type.node >= 0)
+				type_refs(op.result.type.node, op.result.scope, roots);
+			for (int k = 0; k < op.params.size(); ++k)
+				type_refs(op.params[k].type.node, op.params[k].scope, roots);
+		}
+	}
+
+	return roots;
+}
+
+// ----------------------------------------------------------------------------
+int Parser::keyed(int i)
+{
+	/**
+	 * a key field in the struct or in a base (not inherited yet).
+	 * lazy : look for the annotation inside the body, ie.: @key, not @key(FALSE)
+	 */
+	for (int n = 0; i >= 0 && n < structs.size(); ++n) // n : a base cycle ends
+	{
+		const Struct_t& str = structs[i];
+		if (str.lazy)
+		{
+			const char *end = str.body.str + str.body.size;
+			for (const char *s = str.body.str; s < end; ++s)
+			{
+				Span_t name, value;
+				if (*s != '@' || !skip_annotation(s, end, name, value))
+					continue;
+				if (name.equals("key") && !value.equals("FALSE") && !value.equals("false"))
+					return 1;
+			}
+		}
+		else
+		{
+			for (int j = 0; j < str.fields.size(); ++j)
+				if (str.fields[j].is_key)
+					return 1;
+		}
+
+		if (str.base < 0)
+			return 0;
+		int id = find_type(nodes[str.base], str.scope);
+		i = id >= USER_BASE_SPACER_STRUCT ? id - USER_BASE_SPACER_STRUCT : -1;
+	}
+	return 0;
+}
+
+int_v Parser::all_types()
+{
+	int_v ids;
+	int i;
+	for (i = 0; i < structs.size(); ++i)
+		ids.push_back(USER_BASE_SPACER_STRUCT + i);
+	for (i = 0; i < typedefs.size(); ++i)
+		ids.push_back(USER_BASE_SPACER_TYPEDEF + i);
+	for (i = 0; i < enums.size(); ++i)
+		ids.push_back(USER_BASE_SPACER_ENUM + i);
+	return ids;
+}
+
+// ----------------------------------------------------------------------------
+int Parser::is_used(int id)
+{
+	int v = graph_vertex(id);
+	return v < 0 || v >= graph.used.size() || graph.used[v];
+}
+
+// ----------------------------------------------------------------------------
+int Parser::find(const char* name)
+{
+	/** type id of a (scoped) name from the global scope, ie.: "::A::B::T" */
+	TypeNode_t n;
+	Span_t type(name, strlen(name));
+	n.name = scope_split(type, n.scope);
+	n.absolute = true;
+	n.hash = span_hash(n.name);
+	if (is_builtin_type(n.hash, n.type) && n.scope.empty())
+		return n.type;
+	n.type = -1;
+	return find_type(n, 0);
+}
+
+// ----------------------------------------------------------------------------
+#if __cplusplus >= 201103L
+struct ParallelContext_t
+{
+	void (*fn)(void* ctx, int i);
+	void* ctx;
+	int count;
+	std::atomic<int> next;
+};
+
+static void parallel_worker(ParallelContext_t* p)
+{
+	int i;
+	while ((i = p->next++) < p->count)
+		p->fn(p->ctx, i);
+}
+#endif
+
+#define PARALLEL_MIN	16	// item(s) per thread, below : inline (thread start cost)
+
+void Parser::parallel(int count, void (*fn)(void* ctx, int i), void* ctx,
+	int threads)
+{
+#if __cplusplus >= 201103L
+	if (threads <= 0)
+		threads = std::thread::hardware_concurrency();
+	if (threads > count / PARALLEL_MIN)
+		threads = count / PARALLEL_MIN;
+
+	if (threads > 1)
+	{
+		ParallelContext_t p;
+		p.fn = fn;
+		p.ctx = ctx;
+		p.count = count;
+		p.next = 0;
+
+		std::vector<std::thread> workers;
+		for (int t = 1; t < threads; ++t)
+			workers.push_back(std::thread(parallel_worker, &p));
+		parallel_worker(&p);
+		for (int t = 0; t < (int)workers.size(); ++t)
+			workers[t].join();
+		return;
+	}
+#endif
+	/** no thread support : same work, in order */
+	for (int i = 0; i < count; ++i)
+		fn(ctx, i);
+}
+
+// ----------------------------------------------------------------------------
+int Parser::type_layout(int node, int scope, int& align)
+{
+	/** in-memory size of a type tree, -1 if not fixed */
+	align = 1;
+	if ( node < 0 )
+		return -1;
+
+	const TypeNode_t& n = nodes[node];
+
+	/**
+	 * bounded map : flat, inline capacity (no node, no allocation)
+	 * { uint32_t count; K keys[N]; V values[N]; }
+	 */
+	if ( n.type == ID_MAP + TYPE_SPACER && n.size >= 0 )
+	{
+		int key_align, value_align;
+		int key = type_layout( n.child, scope, key_align );
+		int value = type_layout( n.mapped, scope, value_align );
+		if ( key < 0 || value < 0 )
+			return -1;
+
+		int size = 4;
+		size = (size + key_align - 1) / key_align * key_align + n.size * key;
+		size = (size + value_align - 1) / value_align * value_align + n.size * value;
+		align = 4;
+		if ( key_align > align ) align = key_align;
+		if ( value_align > align ) align = value_align;
+		return (size + align - 1) / align * align;
+	}
+
+	if ( n.type >= TYPE_SPACER && n.type < TYPE_SPACER + LAST_TYPE )
+	{
+		int size = __internal_size[n.type - TYPE_SPACER];
+		if ( size > 0 ) align = size;
+		return size;
+	}
+
+	int id = find_type( n, scope );
+	if ( id >= USER_BASE_SPACER_STRUCT )
+	{
+		const Struct_t& str = structs[id - USER_BASE_SPACER_STRUCT];
+		align = str.align;
+		return str.bytes;
+	}
+	if ( id >= USER_BASE_SPACER_TYPEDEF )
+		return typedef_layout( typedefs[id - USER_BASE_SPACER_TYPEDEF], align );
+	if ( id >= USER_BASE_SPACER_ENUM )
+	{
+		align = enums[id - USER_BASE_SPACER_ENUM].bytes;
+		return align;
+	}
+
+	return -1;
+}
+
+int Parser::typedef_layout(const Typedef_t& td, int& align)
+{
+	/** the type tree, times the array size(s) : typedef long A[2][3] > 24 */
+	int size = type_layout( td.node, td.scope, align );
+	for ( int d = 0; d < td.dims && size >= 0; ++d )
+		size *= td.array[d];
+	return size;
+}
+
+// ----------------------------------------------------------------------------
+void Parser::layout_struct(int i)
+{
+	/**
+	 * natural alignment, as a C compiler would do :
+	 * offsets are known up to the first field which is not fixed
+	 */
+	Struct_t& str = structs[i];
+	int offset = 0;
+	int fixed = !str.lazy && !str.forward;
+
+	str.align = 1;
+
+	/** bitset : all the bitfield(s) in a single word */
+	if ( str.type == ID_BITSET + BASE_SPACER )
+	{
+		int bytes = str.bits <= 8 ? 1 : str.bits <= 16 ? 2 : str.bits <= 32 ? 4 : 8;
+		for ( int j = 0; j < str.fields.size(); ++j )
+		{
+			str.fields[j].offset = fixed ? 0 : -1;
+			str.fields[j].bytes = bytes;
+		}
+		str.align = bytes;
+		str.bytes = fixed ? bytes : -1;
+		return;
+	}
+
+	/** union : discriminator, then the biggest branch (shared storage) */
+	if ( str.disc >= 0 )
+	{
+		int align;
+		int disc = type_layout( str.disc, str.scope, align );
+		int size = 0;
+		int branch_align = 1;
+
+		str.align = align;
+		if ( disc < 0 )
+			fixed = 0;
+		for ( int j = 0; j < str.fields.size(); ++j )
+		{
+			Variable_t& v = str.fields[j];
+			v.bytes = type_layout( v.type.node, v.scope, align );
+			for ( int d = 0; d < v.dims && v.bytes >= 0; ++d )
+				v.bytes *= v.array[d];
+
+			if ( v.bytes < 0 )
+				fixed = 0;
+			if ( v.bytes > size )
+				size = v.bytes;
+			if ( align > branch_align )
+				branch_align = align;
+		}
+		if ( branch_align > str.align )
+			str.align = branch_align;
+
+		str.variant = fixed ? (disc + branch_align - 1) / branch_align * branch_align : -1;
+		for ( int j = 0; j < str.fields.size(); ++j )
+			str.fields[j].offset = str.variant;
+		str.bytes = fixed ? 
+			(str.variant + size + str.align - 1) / str.align * str.align : -1;
+		return;
+	}
+
+	/** presence bitmap of the @optional field(s) first */
+	const int bitmap = (str.optionals.size() + 31) / 32 * 4;
+	int_v aligns;
+	if ( bitmap )
+	{
+		offset = bitmap;
+		str.align = 4;
+	}
+	str.order.clear();
+	str.saved = 0;
+	str.cold.clear();
+	str.tail = -1;
+	str.tail_bytes = -1;
+	str.tail_align = 1;
+	int tail = 0;
+	int tail_fixed = fixed;
+	for ( int j = 0; j < str.fields.size(); ++j )
+	{
+		Variable_t& v = str.fields[j];
+		int align;
+		v.bytes = type_layout( v.type.node, v.scope, align );
+		if ( v.aligned > align )
+			align = v.aligned;
+		aligns.push_back( align );
+		for ( int d = 0; d < v.dims && v.bytes >= 0; ++d )
+			v.bytes *= v.array[d];
+
+		/** @cold : laid out in the tail */
+		if ( v.flags & ANN_COLD )
+		{
+			str.cold.push_back( j );
+			if ( v.bytes < 0 )
+				tail_fixed = 0;
+			if ( align > str.tail_align )
+				str.tail_align = align;
+			v.offset = -1;
+			if ( tail_fixed )
+			{
+				tail = (tail + align - 1) / align * align;
+				v.offset = tail;
+				tail += v.bytes;
+			}
+			continue;
+		}
+
+		if ( v.bytes < 0 )
+			fixed = 0;
+		if ( align > str.align )
+			str.align = align;
+
+		if ( fixed )
+		{
+			offset = (offset + align - 1) / align * align;
+			v.offset = offset;
+			offset += v.bytes;
+		}
+		else
+		{
+			v.offset = -1;
+		}
+	}
+
+	/** @cold : pointer to the tail after the hot field(s) */
+	const int pointer = sizeof(void*);
+	if ( str.cold.size() )
+	{
+		if ( pointer > str.align )
+			str.align = pointer;
+		offset = (offset + pointer - 1) / pointer * pointer;
+		str.tail = fixed ? offset : -1;
+		offset += pointer;
+		str.tail_bytes = tail_fixed ?
+			(tail + str.tail_align - 1) / str.tail_align * str.tail_align : -1;
+	}
+
+	/** @align(N) : the size is a multiple too, no false sharing in an array */
+	if ( str.aligned > str.align )
+		str.align = str.aligned;
+
+	str.bytes = fixed ? (offset + str.align - 1) / str.align * str.align : -1;
+
+	/**
+	 * OPT_REORDER : decreasing alignment (stable) leaves no hole, kept only
+	 * if it saves byte(s); a not fixed struct keeps the IDL order
+	 */
+	if ( !reorder || !fixed || str.fields.size() < 2 )
+		return;
+
+	int_v order;
+	for ( int j = 0; j < str.fields.size(); ++j )
+	{
+		if ( str.fields[j].flags & ANN_COLD )
+			continue;
+		int k = order.size();
+		order.push_back( j );
+		for ( ; k > 0 && aligns[order[k - 1]] < aligns[j]; --k )
+			order[k] = order[k - 1];
+		order[k] = j;
+	}
+
+	int_v offsets;
+	offsets.resize( str.fields.size(), 0 );
+	offset = bitmap;
+	for ( int k = 0; k < order.size(); ++k )
+	{
+		int j = order[k];
+		offset = (offset + aligns[j] - 1) / aligns[j] * aligns[j];
+		offsets[j] = offset;
+		offset += str.fields[j].bytes;
+	}
+	int tail_offset = str.tail;
+	if ( str.cold.size() )
+	{
+		tail_offset = offset = (offset + pointer - 1) / pointer * pointer;
+		offset += pointer;
+	}
+	offset = (offset + str.align - 1) / str.align * str.align;
+	if ( offset >= str.bytes )
+		return;
+
+	for ( int k = 0; k < order.size(); ++k )
+		str.fields[order[k]].offset = offsets[order[k]];
+	str.tail = tail_offset;
+	str.order = order;
+	str.saved = str.bytes - offset;
+	str.bytes = offset;
+}
+
+// ----------------------------------------------------------------------------
+int Parser::key_path(int i, const char* path, KeyPath_t& key)
+{
+	/** "a.b" from structs[i] > field indexes and offsets */
+	const char *s = path;
+	key = KeyPath_t();
+	key.path = path;
+	key.offset = 0;
+
+	while ( *s )
+	{
+		const char *e = s;
+		while ( *e && *e != '.' ) e++;
+		hash_t hash = span_hash( Span_t(s, e - s) );
+
+		if ( i < 0 || structs[i].lazy )
+		{
+			TRACE_ERROR("keylist: '" << path << "' is not a member of a struct");
+			return 1;
+		}
+
+		const Struct_t& str = structs[i];
+		int j;
+		for ( j = 0; j < str.fields.size() && str.fields[j].hash != hash; ++j ) {}
+		if ( j == str.fields.size() )
+		{
+			TRACE_ERROR("keylist: unknown member '" << path << "' in " << str.nameSpan);
+			return 1;
+		}
+
+		const Variable_t& v = str.fields[j];
+		key.fields.push_back( j );
+		key.offsets.push_back( v.offset );
+		if ( v.offset < 0 || key.offset < 0 || (v.flags & ANN_COLD) )
+			key.offset = -1;
+		else
+			key.offset += v.offset;
+
+		/** next level : the field must be a struct (not a sequence of) */
+		i = -1;
+		int node = v.type.node;
+		int scope = v.scope;
+		while ( node >= 0 && nodes[node].type < 0 )
+		{
+			int id = find_type( nodes[node], scope );
+			if ( id >= USER_BASE_SPACER_STRUCT )
+				i = id - USER_BASE_SPACER_STRUCT;
+			if ( id < USER_BASE_SPACER_TYPEDEF || id >= USER_BASE_SPACER_STRUCT )
+				break;
+			const Typedef_t& td = typedefs[id - USER_BASE_SPACER_TYPEDEF];
+			if ( td.dims )
+				break; // array : not a struct
+			node = td.node;
+			scope = td.scope; // the typedef target is named from its module
+		}
+
+		s = *e ? e + 1 : e;
+	}
+
+	return 0;
+}
+
+// ----------------------------------------------------------------------------
+void Parser::resolve_keys(int i)
+{
+	Struct_t& str = structs[i];
+	int j, k;
+
+	str.keys.clear();
+	if ( str.lazy || str.forward )
+		return;
+
+	/** #pragma keylist first */
+	for ( j = 0; j < keylists.size(); ++j )
+	{
+		if ( find_keylist(keylists[j]) != USER_BASE_SPACER_STRUCT + i )
+			continue;
+		for ( k = 0; k < keylists[j].keys.size(); ++k )
+		{
+			KeyPath_t key;
+			if ( key_path( i, keylists[j].keys[k], key ) == 0 )
+				str.keys.push_back( key );
+		}
+		return;
+	}
+
+	/** @key field(s) */
+	for ( j = 0; j < str.fields.size(); ++j )
+	{
+		const Variable_t& v = str.fields[j];
+		if ( !v.is_key )
+			continue;
+		KeyPath_t key;
+		key.path = span2String( v.nameSpan );
+		key.fields.push_back( j );
+		key.offsets.push_back( v.offset );
+		key.offset = v.offset;
+		str.keys.push_back( key );
+	}
+}
+
+// ----------------------------------------------------------------------------
+int Parser::extensibility(const Struct_t& str)
+{
+	int ext = str.flags & ANN_EXTENSIBILITY;
+	return ext ? ext : ANN_APPENDABLE; // XTypes default
+}
+
+// ----------------------------------------------------------------------------
+int Parser::is_primitive(int node, int scope)
+{
+	/** built-in type of fixed size, through the typedef(s) */
+	while ( node >= 0 && nodes[node].type < 0 )
+	{
+		int id = find_type( nodes[node], scope );
+		if ( id >= USER_BASE_SPACER_ENUM && id < USER_BASE_SPACER_TYPEDEF )
+			return 1; // enum, bitmask : 1, 2, 4 or 8 byte(s)
+		if ( id >= USER_BASE_SPACER_STRUCT )
+			return structs[id - USER_BASE_SPACER_STRUCT].type == ID_BITSET + BASE_SPACER;
+		if ( id < USER_BASE_SPACER_TYPEDEF || id >= USER_BASE_SPACER_STRUCT )
+			return 0;
+		const Typedef_t& td = typedefs[id - USER_BASE_SPACER_TYPEDEF];
+		if ( td.dims )
+			return 0; // array
+		node = td.node;
+		scope = td.scope;
+	}
+	return node >= 0 && nodes[node].type >= TYPE_SPACER && 
+		nodes[node].type < TYPE_SPACER + LAST_TYPE &&
+		__internal_size[nodes[node].type - TYPE_SPACER] > 0;
+}
+
+// ----------------------------------------------------------------------------
+void Parser::member_table(int i)
+{
+	/**
+	 * @mutable : precomputed EMHEADER1 of each member and member id > field,
+	 * so a decoder reads an EMHEADER and jumps to the field (or skips it)
+	 */
+	Struct_t& str = structs[i];
+	MemberTable_t& t = str.members;
+	t = MemberTable_t();
+
+	if ( str.lazy || str.forward || extensibility(str) != ANN_MUTABLE ||
+		str.fields.size() == 0 )
+		return;
+
+	int j, k;
+	for ( j = 0; j < str.fields.size(); ++j )
+	{
+		Variable_t& v = str.fields[j];
+
+		/** length code : 0..3 > 1, 2, 4, 8 bytes, else 4 (NEXTINT) */
+		uint32_t lc = 4;
+		if ( v.dims == 0 && is_primitive(v.type.node, v.scope) )
+		{
+			switch ( v.bytes )
+			{
+				case 1: lc = 0; break;
+				case 2: lc = 1; break;
+				case 4: lc = 2; break;
+				case 8: lc = 3; break;
+			}
+		}
+		const uint32_t m = (v.flags & (ANN_KEY | ANN_MUST_UNDERSTAND)) ? 1u : 0u;
+		v.emheader = (m << 31) | (lc << 28) | ((uint32_t)v.id & 0x0FFFFFFF);
+
+		for ( k = 0; k < j; ++k )
+		{
+			if ( str.fields[k].id == v.id )
+				TRACE_ERROR("Duplicate member id " << v.id << " in " << str.nameSpan);
+		}
+	}
+
+	int_v ids;
+	for ( j = 0; j < str.fields.size(); ++j )
+		ids.push_back( str.fields[j].id );
+	build_table( t, ids );
+}
+
+// ----------------------------------------------------------------------------
+void Parser::build_table(MemberTable_t& t, const int_v& keys)
+{
+	const int count = keys.size();
+	int lo = count ? keys[0] : 0;
+	int hi = lo;
+	int j;
+
+	t = MemberTable_t();
+	for ( j = 0; j < count; ++j )
+	{
+		if ( keys[j] < lo ) lo = keys[j];
+		if ( keys[j] > hi ) hi = keys[j];
+	}
+
+	/** compact keys (sequential member ids, enum values) : dense table */
+	if ( (int64_t)hi - lo < 4 * count )
+	{
+		t.base = lo;
+		t.index.resize( count ? hi - lo + 1 : 0, -1 );
+		for ( j = count - 1; j >= 0; --j )
+			t.index[ keys[j] - lo ] = j;
+		return;
+	}
+
+	/** sparse keys (@hashid, @autoid(HASH), names) : multiplicative perfect hash */
+	int bits = 1;
+	while ( (1 << bits) < 2 * count ) bits++;
+	uint32_t seed = 0x9E3779B1; // golden ratio
+	for ( int tries = 0; ; ++tries )
+	{
+		if ( tries > 0 && tries % 64 == 0 ) bits++;
+		if ( tries > 0 ) seed = (seed + 0x6D2B79F5) | 1;
+
+		t.seed = seed;
+		t.shift = 32 - bits;
+		t.index.clear();
+		t.ids.clear();
+		t.index.resize( 1 << bits, -1 );
+		t.ids.resize( 1 << bits, -1 );
+		for ( j = 0; j < count; ++j )
+		{
+			unsigned int slot = ((uint32_t)keys[j] * seed) >> t.shift;
+			if ( t.index[slot] >= 0 && t.ids[slot] != keys[j] )
+				break;
+			if ( t.index[slot] < 0 )
+			{
+				t.index[slot] = j;
+				t.ids[slot] = keys[j];
+			}
+		}
+		if ( j == count )
+			break;
+	}
+}
+
+// ----------------------------------------------------------------------------
+void Parser::inherit(int i)
+{
+	/**
+	 * flatten : Derived fields = Base fields (already flattened, dependencies
+	 * first) + own fields, done once. Member ids and presence bits follow
+	 * the ones of the base.
+	 */
+	Struct_t& str = structs[i];
+	if ( str.base < 0 || str.inherited >= 0 || str.lazy || str.forward )
+		return;
+
+	const int id = real_type( str.base, str.scope );
+	if ( id < USER_BASE_SPACER_STRUCT || 
+		structs[id - USER_BASE_SPACER_STRUCT].type != ID_STRUCT + BASE_SPACER )
+	{
+		TRACE_ERROR("struct " << str.nameSpan << ": base is not a struct");
+		return;
+	}
+	const Struct_t& base = structs[id - USER_BASE_SPACER_STRUCT];
+	if ( &base == &str || (base.base >= 0 && base.inherited < 0) )
+	{
+		TRACE_ERROR("struct " << str.nameSpan << ": recursive inheritance");
+		return;
+	}
+
+	/**
+	 * own ids : @id, @hashid (or @autoid(HASH)) are kept, the others are
+	 * renumbered previous + 1, from the biggest base id
+	 */
+	int next_id = 0;
+	int j, k;
+	for ( j = 0; j < base.fields.size(); ++j )
+	{
+		if ( base.fields[j].id >= next_id )
+			next_id = base.fields[j].id + 1;
+	}
+	const bool hashed = (str.flags & ANN_AUTOID_HASH) != 0;
+
+	Variable_t_v fields;
+	int_v optionals;
+	for ( j = 0; j < base.fields.size(); ++j )
+		fields.push_back( base.fields[j] );
+	for ( j = 0; j < base.optionals.size(); ++j )
+		optionals.push_back( base.optionals[j] );
+	for ( j = 0; j < str.fields.size(); ++j )
+	{
+		Variable_t v = str.fields[j];
+		if ( hashed || (v.flags & (ANN_ID | ANN_HASHID)) )
+			next_id = v.id + 1;
+		else
+			v.id = next_id++;
+		for ( k = 0; k < fields.size(); ++k )
+		{
+			if ( fields[k].id == v.id )
+				TRACE_ERROR("struct " << str.nameSpan << ": member id " << v.id <<
+					" of " << v.nameSpan << " already used by " << fields[k].nameSpan);
+		}
+		if ( v.bit >= 0 )
+		{
+			v.bit = optionals.size();
+			optionals.push_back( fields.size() );
+		}
+		fields.push_back( v );
+	}
+
+	str.inherited = base.fields.size();
+	str.fields = fields;
+	str.optionals = optionals;
+}
+
+// ----------------------------------------------------------------------------
+int Parser::type_class(int node, int scope)
+{
+	/** classes of a type tree, see TypeClass_e (structs are classified first) */
+	if ( node < 0 )
+		return CLASS_NONE;
+
+	const TypeNode_t& n = nodes[node];
+	const int all = CLASS_FIXED | CLASS_BOUNDED | CLASS_TRIVIAL;
+
+	/** bounded map : flat (see type_layout()), fixed if its key / value are */
+	if ( n.type == ID_MAP + TYPE_SPACER )
+	{
+		if ( n.size < 0 )
+			return CLASS_NONE;
+		int c = type_class( n.child, scope ) & type_class( n.mapped, scope );
+		return c & (CLASS_FIXED | CLASS_BOUNDED);
+	}
+	if ( n.type == ID_SEQUENCE + TYPE_SPACER )
+		return n.size < 0 ? CLASS_NONE : type_class( n.child, scope ) & CLASS_BOUNDED;
+	if ( n.type == ID_STRING + TYPE_SPACER )
+		return n.size < 0 ? CLASS_NONE : CLASS_BOUNDED;
+	if ( n.type >= TYPE_SPACER && n.type < TYPE_SPACER + LAST_TYPE )
+		return __internal_size[n.type - TYPE_SPACER] > 0 ? all : CLASS_NONE;
+
+	int id = find_type( n, scope );
+	if ( id >= USER_BASE_SPACER_STRUCT )
+		return structs[id - USER_BASE_SPACER_STRUCT].classes;
+	if ( id >= USER_BASE_SPACER_TYPEDEF )
+		return typedef_class( typedefs[id - USER_BASE_SPACER_TYPEDEF] );
+	if ( id >= USER_BASE_SPACER_ENUM )
+	{
+		/** XCDR1 : an enum is written on 4 bytes, whatever its holder */
+		const Enum_t& e = enums[id - USER_BASE_SPACER_ENUM];
+		if ( e.type == ID_ENUM + BASE_SPACER && e.bytes != 4 )
+			return all & ~CLASS_TRIVIAL_XCDR1;
+		return all;
+	}
+
+	return CLASS_NONE;
+}
+
+int Parser::typedef_class(const Typedef_t& td)
+{
+	/** an array has the classes of its element, XCDR2 : DHEADER if not primitive */
+	if ( td.lazy )
+		return CLASS_NONE;
+	int c = type_class( td.node, td.scope );
+	if ( td.dims && !is_primitive(td.node, td.scope) )
+		c &= ~CLASS_TRIVIAL_XCDR2;
+	return c;
+}
+
+void Parser::classify(int i)
+{
+	/** after layout_struct() : the fields and the types they use are done */
+	Struct_t& str = structs[i];
+	str.classes = CLASS_NONE;
+	str.padding = -1;
+	if ( str.lazy || str.forward )
+		return;
+
+	/** bitset : a single word */
+	if ( str.type == ID_BITSET + BASE_SPACER )
+	{
+		str.classes = CLASS_FIXED | CLASS_BOUNDED | CLASS_TRIVIAL;
+		str.padding = 0;
+		return;
+	}
+
+	int classes = CLASS_FIXED | CLASS_BOUNDED | CLASS_TRIVIAL;
+	int payload = (str.optionals.size() + 31) / 32 * 4; // presence bitmap
+	int branch = 0;
+	for ( int j = 0; j < str.fields.size(); ++j )
+	{
+		const Variable_t& v = str.fields[j];
+		classes &= type_class( v.type.node, v.scope );
+		if ( v.dims && !is_primitive(v.type.node, v.scope) )
+			classes &= ~CLASS_TRIVIAL_XCDR2; // DHEADER of the array
+		if ( v.bytes < 0 || (v.flags & ANN_COLD) )
+			continue;
+		if ( str.disc < 0 )
+			payload += v.bytes;
+		else if ( v.bytes > branch )
+			branch = v.bytes;
+	}
+
+	/** union : the bytes after a smaller branch are undefined */
+	if ( str.disc >= 0 )
+	{
+		int align;
+		classes &= type_class( str.disc, str.scope ) & ~CLASS_TRIVIAL;
+		payload += type_layout( str.disc, str.scope, align ) + branch;
+	}
+	if ( str.cold.size() )
+		payload += sizeof(void*); // tail pointer
+	if ( str.optionals.size() || str.order.size() || str.cold.size() ||
+		extensibility(str) == ANN_MUTABLE )
+		classes &= ~CLASS_TRIVIAL; // not the wire order
+	if ( extensibility(str) != ANN_FINAL )
+		classes &= ~CLASS_TRIVIAL_XCDR2; // DHEADER
+
+	if ( str.bytes < 0 )
+		classes &= ~(CLASS_FIXED | CLASS_TRIVIAL);
+	else
+		str.padding = str.bytes - payload;
+	if ( str.padding != 0 )
+		classes &= ~CLASS_TRIVIAL;
+
+	str.classes = classes;
+}
+
+static inline int xcdr_align(int pos, int size, int enc)
+{
+	/** XCDR2 : 8 byte(s) types are aligned on 4 */
+	int align = size > 4 && enc == XCDR2 ? 4 : size;
+	return align > 1 ? (pos + align - 1) / align * align : pos;
+}
+
+int Parser::xcdr_type(int node, int scope, int enc, int pos, int max)
+{
+	/**
+	 * every step (alignment, length) is monotonic : the biggest (smallest)
+	 * bound gives the biggest (smallest) end of the stream
+	 */
+	if ( node < 0 || pos < 0 )
+		return pos;
+
+	const TypeNode_t& n = nodes[node];
+	if ( n.type == ID_STRING + TYPE_SPACER )
+	{
+		if ( max && n.size < 0 )
+			return -1;
+		return xcdr_align( pos, 4, enc ) + 4 + (max ? n.size : 0) + 1; // length, '\0'
+	}
+	if ( n.type == ID_SEQUENCE + TYPE_SPACER || n.type == ID_MAP + TYPE_SPACER )
+	{
+		if ( max && n.size < 0 )
+			return -1;
+		if ( enc == XCDR2 && (!is_primitive(n.child, scope) ||
+			(n.mapped >= 0 && !is_primitive(n.mapped, scope))) )
+			pos = xcdr_align( pos, 4, enc ) + 4; // DHEADER (map : key or value)
+		pos = xcdr_align( pos, 4, enc ) + 4; // length
+		return xcdr_elements( n.child, n.mapped, scope, enc, pos,
+			max ? n.size : 0, max );
+	}
+	if ( n.type >= TYPE_SPACER && n.type < TYPE_SPACER + LAST_TYPE )
+	{
+		int size = __internal_size[n.type - TYPE_SPACER];
+		return size > 0 ? xcdr_align( pos, size, enc ) + size : pos;
+	}
+
+	int id = find_type( n, scope );
+	if ( id >= USER_BASE_SPACER_STRUCT )
+		return xcdr_struct( id - USER_BASE_SPACER_STRUCT, enc, pos, max );
+	if ( id >= USER_BASE_SPACER_TYPEDEF )
+	{
+		const Typedef_t& td = typedefs[id - USER_BASE_SPACER_TYPEDEF];
+		if ( td.lazy || td.node < 0 )
+			return max ? -1 : pos;
+		return xcdr_array( td.node, td.scope, td.dims, td.array, enc, pos, max );
+	}
+	if ( id >= USER_BASE_SPACER_ENUM )
+	{
+		/** XCDR1 : an enum is always 4 bytes, a bitmask (and XCDR2) : bit_bound */
+		const Enum_t& e = enums[id - USER_BASE_SPACER_ENUM];
+		int size = enc == XCDR1 && e.type == ID_ENUM + BASE_SPACER ? 4 : e.bytes;
+		return xcdr_align( pos, size, enc ) + size;
+	}
+
+	return max ? -1 : pos;
+}
+
+int Parser::xcdr_elements(int node, int mapped, int scope, int enc, int pos,
+	int count, int max)
+{
+	/**
+	 * 'count' element(s) (map : key, value) : once an element starts at the
+	 * same alignment (modulo 8) as the first one, the padding repeats
+	 */
+	int first = pos;
+	for ( int k = 0; k < count && pos >= 0; ++k )
+	{
+		pos = xcdr_type( node, scope, enc, pos, max );
+		if ( mapped >= 0 )
+			pos = xcdr_type( mapped, scope, enc, pos, max );
+		if ( pos < 0 || (pos - first) % 8 )
+			continue;
+
+		int cycle = k + 1;
+		int cycles = (count - k - 1) / cycle;
+		pos += cycles * (pos - first);
+		k += cycles * cycle;
+		first = pos;
+	}
+	return pos;
+}
+
+int Parser::xcdr_array(int node, int scope, int dims, const int* array,
+	int enc, int pos, int max)
+{
+	/** a member (struct field, union branch) : an element or an array of them */
+	int count = 1;
+	for ( int d = 0; d < dims; ++d )
+		count *= array[d];
+	if ( enc == XCDR2 && dims && !is_primitive(node, scope) && pos >= 0 )
+		pos = xcdr_align( pos, 4, enc ) + 4; // DHEADER
+	return xcdr_elements( node, -1, scope, enc, pos, count, max );
+}
+
+int Parser::xcdr_struct(int i, int enc, int pos, int max)
+{
+	/**
+	 * a nested struct is computed once per start alignment (see
+	 * Struct_t::xcdr_end), not once per use : S2 { S1 a; S1 b; } ...
+	 */
+	Struct_t& str = structs[i];
+	if ( pos < 0 )
+		return pos;
+	if ( str.lazy || str.forward )
+		return max ? -1 : pos;
+
+	const int slot = (max ? 8 : 0) + pos % 8;
+	if ( !(str.xcdr_done[enc] & (1 << slot)) )
+	{
+		int end = xcdr_members( i, enc, pos, max );
+		str.xcdr_end[enc][slot] = end < 0 ? -1 : end - pos;
+		str.xcdr_done[enc] |= 1 << slot;
+	}
+	return str.xcdr_end[enc][slot] < 0 ? -1 : pos + str.xcdr_end[enc][slot];
+}
+
+int Parser::xcdr_members(int i, int enc, int pos, int max)
+{
+	const Struct_t& str = structs[i];
+
+	/** bitset : the holder word */
+	if ( str.type == ID_BITSET + BASE_SPACER )
+	{
+		int size = str.bits <= 8 ? 1 : str.bits <= 16 ? 2 : str.bits <= 32 ? 4 : 8;
+		return xcdr_align( pos, size, enc ) + size;
+	}
+
+	const int ext = extensibility( str );
+	const int mutable_ = ext == ANN_MUTABLE;
+	if ( enc == XCDR2 && ext != ANN_FINAL )
+		pos = xcdr_align( pos, 4, enc ) + 4; // DHEADER
+
+	/** union : discriminator, then one branch (or none) */
+	if ( str.disc >= 0 )
+	{
+		pos = xcdr_type( str.disc, str.scope, enc, pos, max );
+		int end = max || str.branch_default >= 0 ? -2 : pos;
+		for ( int j = 0; j < str.fields.size() && pos >= 0; ++j )
+		{
+			const Variable_t& v = str.fields[j];
+			int e = xcdr_array( v.type.node, v.scope, v.dims, v.array, enc, pos, max );
+			if ( max && e < 0 )
+				return -1;
+			if ( end == -2 || (max ? e > end : e < end) )
+				end = e;
+		}
+		return end == -2 ? pos : end;
+	}
+
+	for ( int j = 0; j < str.fields.size() && pos >= 0; ++j )
+	{
+		const Variable_t& v = str.fields[j];
+		const int optional = (v.flags & ANN_OPTIONAL) != 0;
+		const int primitive = v.dims == 0 && is_primitive( v.type.node, v.scope );
+
+		/** absent : XCDR1 header (length 0), XCDR2 flag, or nothing (@mutable) */
+		if ( optional && !max )
+		{
+			if ( !mutable_ )
+				pos = enc == XCDR1 ? xcdr_align( pos, 4, enc ) + 4 : pos + 1;
+			continue;
+		}
+
+		/** XCDR1 : parameter header, XCDR2 : EMHEADER [+ NEXTINT] (see member_table()) */
+		const int header = mutable_ || (optional && enc == XCDR1);
+		if ( header )
+		{
+			pos = xcdr_align( pos, 4, enc ) + 4;
+			if ( enc == XCDR2 && !primitive )
+				pos += 4;
+		}
+		else if ( optional )
+		{
+			pos += 1; // XCDR2 : presence flag
+		}
+
+		int start = pos;
+		pos = xcdr_array( v.type.node, v.scope, v.dims, v.array, enc, pos, max );
+
+		/** XCDR1 : extended parameter header (+8) for an id or a length beyond 16 bits */
+		if ( header && enc == XCDR1 && pos >= 0 && (v.id >= 0x3F00 || pos - start > 0xFFFF) )
+			pos = xcdr_array( v.type.node, v.scope, v.dims, v.array, enc, start + 8, max );
+	}
+
+	if ( mutable_ && enc == XCDR1 && pos >= 0 )
+		pos = xcdr_align( pos, 4, enc ) + 4; // PID_SENTINEL
+
+	return pos;
+}
+
+void Parser::serialized_size(int i)
+{
+	/** from the start of the stream (after the encapsulation header) */
+	Struct_t& str = structs[i];
+	for ( int e = 0; e < ENCODINGS; ++e )
+	{
+		str.max_size[e] = xcdr_struct( i, e, 0, 1 );
+		str.min_size[e] = xcdr_struct( i, e, 0, 0 );
+	}
+}
+
+void Parser::size_constants(int i, std::ostream& os)
+{
+	/**
+	 * generated code : one constant per known bound
+	 * ie.: constexpr uint32_t S_max_xcdr2 = 24;
+	 */
+	static const char* names[ENCODINGS] = { "xcdr1", "xcdr2" };
+	const Struct_t& str = structs[i];
+	for ( int e = 0; e < ENCODINGS; ++e )
+	{
+		if ( str.max_size[e] >= 0 )
+			os << "constexpr uint32_t " << str.nameSpan << "_max_" << names[e] <<
+				" = " << str.max_size[e] << ";\n";
+		os << "constexpr uint32_t " << str.nameSpan << "_min_" << names[e] <<
+			" = " << str.min_size[e] << ";\n";
+	}
+}
+
+static void class_name(std::ostream& os, int classes)
+{
+	static const char* names[] = {
+		"unbounded", "fixed unbounded", "bounded", "fixed bounded"
+	};
+	static const char* trivial[] = {
+		"", " trivial(xcdr1)", " trivial(xcdr2)", " trivial"
+	};
+	os << names[classes & 3] << trivial[(classes & CLASS_TRIVIAL) >> 2];
+}
+
+void Parser::report(std::ostream& os)
+{
+	/**
+	 * one line per type (dependencies first), then the field(s) of a struct :
+	 * ie.: struct A::S : 16 byte(s), align 8, padding 7 (43%), fixed bounded
+	 *        +0 1 c
+	 *        +8 8 d
+	 */
+	for ( int i = 0; i < graph.order.size(); ++i )
+	{
+		int v = graph.order[i];
+		if ( !is_used( graph_id(v) ) || v >= structs.size() + typedefs.size() )
+			continue;
+
+		if ( v >= structs.size() )
+		{
+			const Typedef_t& td = typedefs[v - structs.size()];
+			int align;
+			int bytes = typedef_layout( td, align );
+			os << "typedef " << modules[td.scope].nameSpace <<
+				(td.scope ? "::" : "") << td.nameSpan << " : ";
+			if ( bytes < 0 )
+				os << "not fixed";
+			else
+				os << bytes << " byte(s), align " << align;
+			os << ", ";
+			class_name( os, td.classes );
+			os << "\n";
+			continue;
+		}
+
+		const Struct_t& str = structs[v];
+		if ( str.lazy || str.forward )
+			continue;
+		os << type2Name( str.type ) << " " << modules[str.scope].nameSpace <<
+			(str.scope ? "::" : "") << str.nameSpan << " : ";
+		if ( str.bytes < 0 )
+			os << "not fixed";
+		else
+			os << str.bytes << " byte(s), align " << str.align << ", padding " <<
+				str.padding << " (" << (str.bytes ? str.padding * 100 / str.bytes : 0) <<
+				"%)";
+		os << ", ";
+		class_name( os, str.classes );
+		for ( int e = 0; e < ENCODINGS; ++e )
+		{
+			os << (e == XCDR1 ? ", xcdr1 " : ", xcdr2 ") << str.min_size[e] << "..";
+			if ( str.max_size[e] < 0 ) os << "?"; else os << str.max_size[e];
+		}
+		if ( str.saved )
+			os << ", reordered : " << str.saved << " byte(s) saved";
+		os << "\n";
+
+		/** in-memory order : the hot field(s), then the tail */
+		int_v order = str.order;
+		if ( order.empty() )
+		{
+			for ( int j = 0; j < str.fields.size(); ++j )
+				if ( !(str.fields[j].flags & ANN_COLD) )
+					order.push_back( j );
+		}
+		for ( int k = 0; k < str.cold.size(); ++k )
+			order.push_back( str.cold[k] );
+
+		for ( int k = 0; k < order.size(); ++k )
+		{
+			const Variable_t& f = str.fields[order[k]];
+			if ( k == order.size() - str.cold.size() )
+			{
+				os << "  tail ";
+				if ( str.tail < 0 ) os << "+?"; else os << "+" << str.tail;
+				os << " : ";
+				if ( str.tail_bytes < 0 ) os << "not fixed"; else os << str.tail_bytes << " byte(s)";
+				os << ", align " << str.tail_align << "\n";
+			}
+			os << (f.flags & ANN_COLD ? "    " : "  ");
+			if ( f.offset < 0 ) os << "+?"; else os << "+" << f.offset;
+			os << " ";
+			if ( f.bytes < 0 ) os << "?"; else os << f.bytes;
+			os << " " << f.nameSpan << "\n";
+		}
+	}
+}
+
+// ----------------------------------------------------------------------------
+int Parser::real_type(int node, int scope)
+{
+	/** type id of a type tree through the typedef(s), -1 if unknown */
+	while ( node >= 0 )
+	{
+		int id = find_type( nodes[node], scope );
+		if ( id < USER_BASE_SPACER_TYPEDEF || id >= USER_BASE_SPACER_STRUCT )
+			return id;
+		const Typedef_t& td = typedefs[id - USER_BASE_SPACER_TYPEDEF];
+		node = td.node;
+		scope = td.scope;
+	}
+	return -1;
+}
+
+// ----------------------------------------------------------------------------
+int Parser::label_value(const Span_t& label, int disc, int scope, int& value)
+{
+	/** enumerator of the discriminator, else a constant expression */
+	if ( disc >= USER_BASE_SPACER_ENUM && disc < USER_BASE_SPACER_TYPEDEF )
+	{
+		Span_t sc;
+		Span_t name = scope_split( label, sc );
+		if ( enum_value( disc - USER_BASE_SPACER_ENUM, name.str, name.size, value ) )
+			return 1;
+	}
+
+	ConstValue_t v;
+	if ( label.empty() || fold( label, scope, v ) )
+		return 0;
+	value = v.is_real ? (int)v.real : (int)v.integer;
+	return 1;
+}
+
+// ----------------------------------------------------------------------------
+void Parser::case_table(int i)
+{
+	/**
+	 * union : case label(s) > value(s), then discriminator > branch,
+	 * a dense jump table when the labels are compact
+	 */
+	Struct_t& str = structs[i];
+	if ( str.disc < 0 || str.lazy || str.forward )
+		return;
+
+	const int disc = real_type( str.disc, str.scope );
+	if ( disc >= USER_BASE_SPACER_TYPEDEF || disc == ID_STRING + TYPE_SPACER ||
+		disc == ID_SEQUENCE + TYPE_SPACER || disc == ID_FLOAT + TYPE_SPACER ||
+		disc == ID_DOUBLE + TYPE_SPACER )
+	{
+		TRACE_ERROR("union " << str.nameSpan << ": bad discriminator type");
+	}
+
+	int j, k;
+	str.values.clear();
+	for ( k = 0; k < str.labels.size(); ++k )
+	{
+		int value = 0;
+		if ( !label_value( str.labels[k], disc, str.scope, value ) )
+			TRACE_ERROR("union " << str.nameSpan << ": unknown case label '" <<
+				str.labels[k] << "'");
+		for ( j = 0; j < k; ++j )
+		{
+			if ( str.values[j] == value )
+				TRACE_ERROR("union " << str.nameSpan << ": duplicate case label '" <<
+					str.labels[k] << "'");
+		}
+		str.values.push_back( value );
+	}
+
+	build_table( str.cases, str.values );
+	for ( j = 0; j < str.cases.index.size(); ++j )
+	{
+		if ( str.cases.index[j] >= 0 )
+			str.cases.index[j] = str.branches[ str.cases.index[j] ];
+	}
+}
+
+// ----------------------------------------------------------------------------
+int Parser::find_keylist(const Keylist_t& keylist)
+{
+	/** scoped name, else the first type with this name in any module */
+	int id = find( keylist.type );
+	if ( id < USER_BASE_SPACER_TYPEDEF )
+	{
+		Span_t scope;
+		Span_t name = scope_split( Span_t(keylist.type, keylist.type.size()), scope );
+		if ( !is_struct( span_hash(name), id ) )
+			id = -1;
+	}
+	return id;
+}
+
+// ----------------------------------------------------------------------------
+void Parser::forward_struct(const Span_t& name)
+{
+	/** struct X; the definition will take the same slot */
+	hash_t hash = span_hash(name);
+	Map<hash_t, int>::iterator it = modules[scope].types.find(hash);
+
+	if ( it != modules[scope].types.end() )
+		return; // already declared
+
+	Struct_t str;
+	str.hash = hash;
+	str.type = ID_STRUCT + BASE_SPACER;
+	str.forward = true;
+	str.nameSpace = nameSpace;
+	str.scope = scope;
+	str.nameSpan = name;
+	if ( !span_model )
+		str.name = span2String(name);
+
+	structs.push_back( str );
+	declare( hash, USER_BASE_SPACER_STRUCT + structs.size() - 1 );
+}
+
+// ----------------------------------------------------------------------------
+int Parser::parse_const(const char *src)
+{
+	/** const type NAME = expression ; (after 'const') */
+	const char *s = src;
+	s += skip_spaces(s);
+	const char *begin = s;
+	s += read_block(s, NULL, 0, 0, ';');
+	const char *end = s;
+	if (end > begin && *(end - 1) == ';') end--;
+
+	const char *eq = begin;
+	while (eq < end && *eq != '=') eq++;
+	if (eq == end)
+	{
+		TRACE_ERROR("const without value: " << Span_t(begin, end - begin));
+		return s - src;
+	}
+
+	Const_t c;
+	c.nameSpan = rfind_name(begin, eq);
+	c.hash = span_hash(c.nameSpan);
+	c.scope = scope;
+	c.nameSpace = nameSpace;
+	if (!span_model)
+		c.name = span2String(c.nameSpan);
+	parse_type_spec(begin, c.nameSpan.str, c.node);
+
+	const char *e = eq + 1;
+	while (e < end && isspace(*e)) e++;
+	const char *x = end;
+	while (x > e && isspace(*(x - 1))) x--;
+	c.expr = Span_t(e, x - e);
+	fold(c.expr, scope, c.value);
+
+	/** to the declared type */
+	ConstValue_t& v = c.value;
+	const int type = real_type(c.node, scope);
+	if (type == ID_FLOAT + TYPE_SPACER || type == ID_DOUBLE + TYPE_SPACER)
+	{
+		if (!v.is_real) v.real = (double)v.integer;
+		v.is_real = true;
+	}
+	else if (v.is_real && type != ID_STRING + TYPE_SPACER)
+	{
+		v.integer = (int64_t)v.real;
+		v.is_real = false;
+	}
+
+	MY_DEBUG("Storing const : " << c.nameSpan << " = " << c.expr << " > " <<
+		(v.is_real ? v.real : (double)v.integer));
+
+	consts.push_back(c);
+	modules[scope].consts[c.hash] = consts.size() - 1;
+
+	return s - src;
+}
+
+// ----------------------------------------------------------------------------
+int Parser::find_const(const Span_t& scoped, int from)
+{
+	/** constant of a (scoped) name, see find_type(), -1 if unknown */
+	Span_t sc;
+	Span_t name = scope_split(scoped, sc);
+	const bool absolute = scoped.size > 0 && scoped.str[0] == ':';
+	const hash_t hash = span_hash(name);
+
+	if (!sc.empty() || absolute)
+	{
+		int m = sc.empty() ? 0 : find_scope(sc, absolute, from);
+		if (m < 0)
+			return -1;
+		Map<hash_t, int>::iterator it = modules[m].consts.find(hash);
+		return it != modules[m].consts.end() ? it->second : -1;
+	}
+
+	for (int i = from; i >= 0; i = modules[i].parent)
+	{
+		Map<hash_t, int>::iterator it = modules[i].consts.find(hash);
+		if (it != modules[i].consts.end())
+			return it->second;
+	}
+
+	return -1;
+}
+
+// ----------------------------------------------------------------------------
+int Parser::fold(const Span_t& expr, int scope, ConstValue_t& value)
+{
+	/** 
+	 * constant expression > value, return the count of error(s)
+	 * ie.: "(N << 2) + 1", "1.5 * 2", "'a'", "\"text\"", "::M::RED"
+	 */
+	const char *s = expr.str;
+	const char *end = expr.str + expr.size;
+	value = ConstValue_t();
+
+	int errors = fold_binary(s, end, scope, 0, value);
+	while (s < end && isspace(*s)) s++;
+	if (s < end)
+	{
+		TRACE_ERROR("Bad constant expression: '" << expr << "'");
+		errors++;
+	}
+	return errors;
+}
+
+int Parser::fold_binary(const char *&s, const char *end, int scope, int level,
+	ConstValue_t& v)
+{
+	/** precedence : | ^ & << >> + - * / % (IDL 7.4.1.4.4) */
+	static const char *operators[] = { "|", "^", "&", "<>", "+-", "*/%" };
+	if (level == ARRAY_SIZE(operators))
+		return fold_unary(s, end, scope, v);
+
+	int errors = fold_binary(s, end, scope, level + 1, v);
+	for (;;)
+	{
+		while (s < end && isspace(*s)) s++;
+		if (s >= end || !strchr(operators[level], *s))
+			break;
+
+		const char op = *s++;
+		if (op == '<' || op == '>')
+		{
+			if (s >= end || *s != op)
+			{
+				s--;
+				break;
+			}
+			s++;
+		}
+
+		ConstValue_t r;
+		errors += fold_binary(s, end, scope, level + 1, r);
+
+		if (v.is_real || r.is_real)
+		{
+			double a = v.is_real ? v.real : (double)v.integer;
+			double b = r.is_real ? r.real : (double)r.integer;
+			v.is_real = true;
+			switch (op)
+			{
+				case '+': v.real = a + b; break;
+				case '-': v.real = a - b; break;
+				case '*': v.real = a * b; break;
+				case '/': v.real = a / b; break;
+				default:
+					TRACE_ERROR("Bad operator '" << op << "' on a floating value");
+					errors++;
+			}
+			continue;
+		}
+
+		int64_t a = v.integer;
+		int64_t b = r.integer;
+		if ((op == '/' || op == '%') && b == 0)
+		{
+			TRACE_ERROR("Division by zero in a constant expression");
+			errors++;
+			continue;
+		}
+		switch (op)
+		{
+			case '|': v.integer = a | b; break;
+			case '^': v.integer = a ^ b; break;
+			case '&': v.integer = a & b; break;
+			case '<': v.integer = (int64_t)((uint64_t)a << (b & 63)); break;
+			case '>': v.integer = a >> (b & 63); break;
+			case '+': v.integer = a + b; break;
+			case '-': v.integer = a - b; break;
+			case '*': v.integer = a * b; break;
+			case '/': v.integer = a / b; break;
+			case '%': v.integer = a % b; break;
+		}
+	}
+
+	return errors;
+}
+
+int Parser::fold_unary(const char *&s, const char *end, int scope,
+	ConstValue_t& v)
+{
+	/** unary : - + ~ (expression) literal name */
+	int errors = 0;
+	while (s < end && isspace(*s)) s++;
+	if (s >= end)
+	{
+		TRACE_ERROR("Missing operand in a constant expression");
+		return 1;
+	}
+
+	if (*s == '-' || *s == '+' || *s == '~')
+	{
+		const char op = *s++;
+		errors += fold_unary(s, end, scope, v);
+		if (op == '-')
+		{
+			v.integer = -v.integer;
+			v.real = -v.real;
+		}
+		else if (op == '~')
+		{
+			if (v.is_real) { TRACE_ERROR("Bad operator '~' on a floating value"); errors++; }
+			v.integer = ~v.integer;
+		}
+		return errors;
+	}
+
+	if (*s == '(')
+	{
+		s++;
+		errors += fold_binary(s, end, scope, 0, v);
+		while (s < end && isspace(*s)) s++;
+		if (s < end && *s == ')') s++;
+		else { TRACE_ERROR("Missing ')' in a constant expression"); errors++; }
+		return errors;
+	}
+
+	/** number : 10, 0x1F, 017, 1.5, 1e3 */
+	if (isdigit(*s) || (*s == '.' && s + 1 < end && isdigit(s[1])))
+	{
+		char *e;
+		v.integer = strtoll(s, &e, 0);
+		if (e < end && (*e == '.' || *e == 'e' || *e == 'E') && 
+			!(s[0] == '0' && (s[1] == 'x' || s[1] == 'X')))
+		{
+			v.real = strtod(s, &e);
+			v.is_real = true;
+		}
+		s = e;
+		while (s < end && strchr("dDfFlLuU", *s)) s++; // suffix
+		return 0;
+	}
+
+	/** 'c', '\n' */
+	if (*s == '\'')
+	{
+		s++;
+		if (s < end && *s == '\\')
+		{
+			s++;
+			switch (s < end ? *s : 0)
+			{
+				case 'n': v.integer = '\n'; break;
+				case 't': v.integer = '\t'; break;
+				case 'r': v.integer = '\r'; break;
+				case '0': v.integer = 0; break;
+				default: v.integer = (unsigned char)*s; break;
+			}
+		}
+		else if (s < end)
+		{
+			v.integer = (unsigned char)*s;
+		}
+		s++;
+		if (s < end && *s == '\'') s++;
+		return 0;
+	}
+
+	/** "text" */
+	if (*s == '"')
+	{
+		const char *b = ++s;
+		while (s < end && (*s != '"' || *(s - 1) == '\\')) s++;
+		v.text = Span_t(b, s - b);
+		if (s < end) s++;
+		return 0;
+	}
+
+	/** name : TRUE, FALSE, constant, enumerator */
+	Span_t name(s, 0);
+	while (s < end && (isalnum(*s) || strchr("_:", *s))) s++;
+	name.size = s - name.str;
+	if (name.empty())
+	{
+		TRACE_ERROR("Bad constant expression: '" << *s << "'");
+		s = end;
+		return 1;
+	}
+	if (name.equals("TRUE")) { v.integer = 1; return 0; }
+	if (name.equals("FALSE")) { v.integer = 0; return 0; }
+
+	int c = find_const(name, scope);
+	if (c >= 0)
+	{
+		v = consts[c].value;
+		return 0;
+	}
+
+	/** enumerator : declared in the scope of its enum */
+	Span_t sc;
+	Span_t n = scope_split(name, sc);
+	const bool absolute = name.str[0] == ':';
+	int from = (!sc.empty() || absolute) ? 
+		(sc.empty() ? 0 : find_scope(sc, absolute, scope)) : scope;
+	for (int m = from; m >= 0; m = (sc.empty() && !absolute) ? modules[m].parent : -1)
+	{
+		for (int i = 0; i < enums.size(); ++i)
+		{
+			int value;
+			if (enums[i].scope == m && enum_value(i, n.str, n.size, value))
+			{
+				v.integer = value;
+				return 0;
+			}
+		}
+	}
+
+	TRACE_ERROR("Unknown constant: " << name);
+	return 1;
+}
+
+// ----------------------------------------------------------------------------
+void Parser::parse_interface(const Span_t& name, const Span_t& bases,
+	const Span_t& body)
+{
+	Interface_t itf;
+	itf.hash = span_hash(name);
+	if ( !span_model )
+	{
+		itf.name = span2String(name);
+	}
+	itf.nameSpace = nameSpace;
+	itf.scope = scope;
+	itf.nameSpan = name;
+	itf.body = body;
+
+	/** operations of the base(s) first : interface X : A, ::M::B */
+	const char *s = bases.str;
+	const char *end = bases.str + bases.size;
+	int j;
+	while ( s < end )
+	{
+		while ( s < end && (isspace(*s) || *s == ',') ) s++;
+		const char *b = s;
+		while ( s < end && (isalnum(*s) || strchr("_:", *s)) ) s++;
+		if ( s == b )
+		{
+			s++;
+			continue;
+		}
+
+		int k = find_interface( Span_t(b, s - b), scope );
+		if ( k < 0 )
+		{
+			TRACE_ERROR("interface " << name << ": unknown base " << Span_t(b, s - b));
+			continue;
+		}
+		for ( j = 0; j < interfaces[k].operations.size(); ++j )
+			itf.operations.push_back( interfaces[k].operations[j] );
+	}
+	itf.inherited = itf.operations.size();
+
+	/** [oneway] type name(parameter(s)) [raises(...)] [context(...)] ; */
+	s = body.str;
+	end = body.str + body.size;
+	while ( s < end )
+	{
+		Annotation_t annotation;
+		s += parse_annotations(s, end, annotation);
+		while ( s < end && isspace(*s) ) s++;
+		if ( s >= end ) break;
+		if ( *s == ';' ) { s++; continue; }
+
+		/** end of the declaration : ';' out of any block */
+		const char *e = s;
+		int depth = 0;
+		while ( e < end && (depth > 0 || *e != ';') )
+		{
+			if ( *e == '{' || *e == '(' ) depth++;
+			else if ( *e == '}' || *e == ')' ) depth--;
+			e++;
+		}
+		const Span_t declaration(s, e - s);
+
+		Span_t word(s, 0);
+		while ( s + word.size < e && (isalnum(s[word.size]) || s[word.size] == '_') )
+			word.size++;
+
+		bool oneway = false;
+		if ( word.equals("oneway") )
+		{
+			oneway = true;
+			s += word.size;
+		}
+		else if ( word.equals("attribute") || word.equals("readonly") ||
+			word.equals("exception") || word.equals("struct") ||
+			word.equals("union") || word.equals("enum") ||
+			word.equals("typedef") || word.equals("const") )
+		{
+			TRACE_WARNING("interface " << name << ": '" << word << "' is not supported");
+			s = e < end ? e + 1 : e;
+			continue;
+		}
+
+		int node;
+		s += parse_type_spec(s, e, node);
+		Span_t op;
+		s += read_span(s, op);
+		s += skip_spaces(s);
+		if ( s >= e || *s != '(' )
+		{
+			TRACE_ERROR("interface " << name << ": bad operation '" << declaration << "'");
+			s = e < end ? e + 1 : e;
+			continue;
+		}
+
+		const char *args = ++s;
+		for ( depth = 1; s < e && depth > 0; s++ )
+		{
+			if ( *s == '(' ) depth++;
+			else if ( *s == ')' ) depth--;
+		}
+		parse_function( itf, node, op, Span_t(args, s - 1 - args), oneway );
+
+		s = e < end ? e + 1 : e;
+	}
+
+	/** server dispatch : name > operation */
+	int_v keys;
+	for ( j = 0; j < itf.operations.size(); ++j )
+	{
+		const Span_t& n = itf.operations[j].nameSpan;
+		keys.push_back( name_hash(n.str, n.size) );
+	}
+	build_table( itf.dispatch, keys );
+
+	MY_DEBUG("Storing interface : " << name << " (" << itf.operations.size() <<
+		" operation(s))");
+
+	interfaces.push_back( itf );
 }
 
-void Parser::parse_typedef(const char* body)
+void Parser::parse_function(Interface_t& itf, int node, const Span_t& name,
+	const Span_t& args, bool oneway)
 {
-	TRACE_DEBUG( "Typedef: '" << body << "'" );
-	String input(body);
-	input.replace(", ", ","); // seq<name, size>
-
-	String_v mar = Explode( input, ' ' );
-	Typedef_t typeDef;
-	hash_t b_hash = 0;
-	int result=0;
-
-	if ( mar.size() >= 2 )
+	Operation_t op;
+	op.hash = span_hash(name);
+	op.nameSpan = name;
+	if ( !span_model )
 	{
-		b_hash = getHash( mar[0] );
+		op.name = span2String(name);
 	}
+	op.oneway = oneway;
 
-	if ( is_builtin_type(b_hash, result) || 
-			is_user_base(b_hash, result) )
+	if ( node >= 0 && nodes[node].type != ID_VOID + TYPE_SPACER )
 	{
-		String baseTypeName( type2Name(result) );
-		String newTypeName( mar[1] );
-		TRACE_DEBUG("Storing typedef > baseTypeName: '" << baseTypeName << 
-			"' newTypeName: '" << newTypeName << "'" );
-
-		/** store new type */
-		b_hash = getHash( newTypeName );
-		typeDef.hash = b_hash;
-		typeDef.type = result;
-		typeDef.name = newTypeName;
-		typeDef.baseName = baseTypeName;
-		typeDef.nameSpace = nameSpace;
-		typedefs.push_back( typeDef );
+		op.result.type.node = node;
+		op.result.scope = scope;
+		op.result.nameSpan = name;
+		op.result.dir = PARAM_OUT;
 	}
-	// TODO: rewrite me this sh** ....
-	else if ( mar[0].find("sequence") != String::npos )
-	{
-		String tStr(mar[0]);
-		String_v mar2;
-		/** TODO handle sequence */
-		TRACE_ERROR("Type is a sequence: '" << mar[0] << "'");
-		
-		tStr.replace("<"," ");
-		tStr.replace(">"," ");
-		mar2 = Explode(tStr.c_str(), ' ');
 
-		/**
-		 * a sequence can be :
-		 * sequence<type> name
-		 * sequence<type,size> name
-		 * 
-		 * mar[0] == sequence<type>
-		 * mar[1] == name
-		 * mar2[1] == type name
-		 */
-		b_hash = getHash( mar[1] );
-		typeDef.hash = b_hash;
-		// hackish
-		typeDef.type = ID_SEQUENCE + TYPE_SPACER;
-		typeDef.name = mar[1];
-		typeDef.baseName = mar2[1];
-		typeDef.size = 0;
-		typeDef.nameSpace = nameSpace;
+	/** [annotation(s)] in|out|inout type name [, ...] */
+	const char *s = args.str;
+	const char *end = args.str + args.size;
+	while ( s < end )
+	{
+		/** one parameter : up to ',' out of a template */
+		const char *e = s;
+		int depth = 0;
+		while ( e < end && (depth > 0 || *e != ',') )
+		{
+			if ( *e == '<' ) depth++;
+			else if ( *e == '>' ) depth--;
+			e++;
+		}
 
-		/** check for sequence size */
-		mar2 = Explode( mar[0].c_str(), ',' );
-		if ( mar2.size() >= 2 )
-		{
-			/**
-			 * mar2[0] == type
-			 * mar2[1] == size
-			 */
-			String_v mar3;
-			mar2[0].replace("<"," "); /** 'sequence type' */
-			mar2[1].replace(">","");
-			mar3 = Explode(mar2[0], ' ' );
-			TRACE_DEBUG( "mar2 > 0: '" << mar2[0] << "' 1:" << mar2[1] );
-
-			if ( mar3.size() == 2 )
-			{
-				Typedef_t t;
-				/**
-				 * mar3[0] == sequence
-				 * mar3[1] == type
-				 */
-				 t = getRealType(getHash(mar3[1]));
-				 t.type = ID_SEQUENCE + TYPE_SPACER;
-				 typeDef.baseName = t.name;
-				 TRACE_DEBUG( "mar3 > : " << t.name );
-			}
-			typeDef.size = atol( mar2[1].c_str() );
-			
-			TRACE_DEBUG( "typeDef.size > : " << typeDef.size );
+		Annotation_t annotation;
+		s += parse_annotations(s, e, annotation);
+		while ( s < e && isspace(*s) ) s++;
+		if ( s < e )
+		{
+			int dir = PARAM_IN;
+			if ( !strncmp(s, "inout", 5) && isspace(s[5]) ) { dir = PARAM_INOUT; s += 5; }
+			else if ( !strncmp(s, "out", 3) && isspace(s[3]) ) { dir = PARAM_OUT; s += 3; }
+			else if ( !strncmp(s, "in", 2) && isspace(s[2]) ) { s += 2; }
+			else TRACE_ERROR("operation " << name << ": missing direction (in, out, inout)");
+			s += parse_annotations(s, e, annotation); // in @key long id
+
+			Span_t param = rfind_name(s, e);
+			int type;
+			parse_type_spec(s, param.str, type);
+
+			Variable_t v = parse_variable( type, itf.name, param,
+				nodes[type].scope, annotation );
+			v.dir = dir;
+			if ( dir & PARAM_IN ) op.request.push_back( op.params.size() );
+			if ( dir & PARAM_OUT ) op.reply.push_back( op.params.size() );
+			op.params.push_back( v );
 		}
-		typedefs.push_back( typeDef );
+
+		s = e < end ? e + 1 : e;
 	}
-	else
+
+	if ( oneway && (op.reply.size() || op.result.type.node >= 0) )
+		TRACE_ERROR("oneway operation " << name << " with a result or out parameter(s)");
+
+	itf.operations.push_back( op );
+}
+
+int Parser::find_interface(const Span_t& scoped, int from)
+{
+	/** interface of a (scoped) name, see find_type(), -1 if unknown */
+	Span_t sc;
+	Span_t name = scope_split(scoped, sc);
+	const bool absolute = scoped.size > 0 && scoped.str[0] == ':';
+	const bool relative = sc.empty() && !absolute;
+	const hash_t hash = span_hash(name);
+
+	int m = relative ? from : (sc.empty() ? 0 : find_scope(sc, absolute, from));
+	for ( ; m >= 0; m = relative ? modules[m].parent : -1 )
 	{
-		TRACE_ERROR("Unknown type: " << mar[0] );
+		for ( int i = 0; i < interfaces.size(); ++i )
+		{
+			if ( interfaces[i].hash == hash && interfaces[i].scope == m )
+				return i;
+		}
 	}
+
+	return -1;
+}
+
+int Parser::operation(int i, const char *name, int size)
+{
+	/** server dispatch : operation name > operation index, -1 if unknown */
+	const Interface_t& itf = interfaces[i];
+	int k = itf.dispatch.find( name_hash(name, size) );
+	if ( k < 0 || itf.operations[k].nameSpan.size != size ||
+		strncmp(itf.operations[k].nameSpan.str, name, size) )
+		return -1;
+	return k;
 }
 
 // ----------------------------------------------------------------------------
 Variable_t Parser::parse_variable(
-	hash_t type, const char* struct_name, const char *name,
-	const char* fromNamespace, bool is_key )
+	int node, const char* struct_name, const Span_t& name,
+	const Span_t& fromNamespace, const Annotation_t& annotation )
 {
+	const bool is_key = (annotation.flags & ANN_KEY) != 0;
 	Variable_t v;
 
-	v.type = getRealType( type ); // std type or user type
-
-	printf("variable %s type: %s", name, v.type.name.c_str() );
+	/** std type or user type, resolved later (see resolve()) */
+	v.type.node = node;
+	v.scope = scope;
 
-	v.hash = getHash(name);
-
-	v.name = name;
+	v.hash = span_hash(name);
 	v.is_key = is_key;
-	v.struct_name = struct_name;
-	v.fromNamespace = fromNamespace;
+	v.flags = annotation.flags;
+	v.nameSpan = name;
+	if ( annotation.flags & ANN_ALIGN )
+		v.aligned = annotation.align;
+	if ( (v.flags & ANN_COLD) && is_key )
+	{
+		TRACE_WARNING("@cold ignored on the key member " << name);
+		v.flags &= ~ANN_COLD;
+	}
+
+	if ( !span_model )
+	{
+		v.name = span2String(name);
+		v.struct_name = struct_name;
+		v.fromNamespace = span2String(fromNamespace);
+	}
 
 	// TODO: check if the namespace is known
 
@@ -649,8 +3890,6 @@ Variable_t Parser::parse_variable(
 		);
 	}
 
-	variables.push_back( v );
-
 	return v;
 }
 
@@ -664,11 +3903,17 @@ int IdlParser::parse(const char* src)
 	{
 		s += skip_spaces(s);
 
-		// read current line
+		// read current line (bounded : never walk the whole source)
 		const char *l = s;
-		while (l > src && *(l - 1) != '\n') l--;
-		MY_DEBUG("read_block(" << l << ")");
-		read_block(l, line, sizeof(line), 0, '\n');
+		int n = 0;
+		while (l > src && *(l - 1) != '\n' && s - l < (int)sizeof(line) - 1) l--;
+		while (l[n] && l[n] != '\n' && n < (int)sizeof(line) - 1)
+		{
+			line[n] = l[n];
+			n++;
+		}
+		line[n] = '\0';
+		MY_DEBUG("read_block(" << line << ")");
 
 		// end of source
 		if (*s == '\0')
@@ -692,6 +3937,16 @@ int IdlParser::parse(const char* src)
 			s++;
 			break;
 		}
+		// type annotation(s), for the next declaration
+		else if (*s == '@')
+		{
+			const char *end = s;
+			while (*end && *end != '{' && *end != ';') end++;
+			int len = parse_annotations(s, end, annotation);
+			if (len == 0) { TRACE_ERROR("Parser::parse(): bad annotation"); s++; }
+			s += len;
+			continue;
+		}
 		// check next symbol
 		else if ( (isalpha(*s) == 0) && 
 			(strchr("_:", *s) == NULL) )
@@ -701,18 +3956,28 @@ int IdlParser::parse(const char* src)
 
 		// read next token
 		char buf[256];
+		const char *token = s;
 		MY_DEBUG("read_token()");
 		s += read_token(s, buf, sizeof(buf));
 		if (buf[0] == '\0') break;
 
 		const hash_t b_hash = getHash(buf);
 
+		/** annotation(s) apply to this declaration only */
+		const Annotation_t pending = annotation;
+		annotation = Annotation_t();
+
 		printf("token: %s\n", buf);
 
 		int result = 0;
 
+		// constant : const type NAME = expression;
+		if ( is_builtin_type(b_hash, result) && result == ID_CONST + TYPE_SPACER )
+		{
+			s += parse_const(s);
+		}
 		// variable or function (can be built-in type or user type)
-		if ( is_builtin_type(b_hash, result) || 
+		else if ( is_builtin_type(b_hash, result) || 
 			is_user_base(b_hash, result) )
 		{
 			MY_DEBUG("\t>> Builtin");
@@ -726,11 +3991,14 @@ int IdlParser::parse(const char* src)
 			{
 				MY_DEBUG("\t\t>> variable");
 				s = begin;
-				char variables[4096];
 				MY_DEBUG("read_block()");
-				s += read_block(s, variables, sizeof(variables), 0, ';');
+				s += read_block(s, NULL, 0, 0, ';');
 				MY_DEBUG("parse_variable()");
-				parse_variable(b_hash, "", variables, "" );
+				int node;
+				parse_type_spec(token, s - 1, node);
+				/** global variable : a field is only stored in its struct */
+				variables.push_back(
+					parse_variable(node, "", rfind_name(begin, s - 1), Span_t()) );
 			}
 		}
 		else if (Parser::is_builtin_base(b_hash, result))
@@ -741,27 +4009,149 @@ int IdlParser::parse(const char* src)
 			{
 				case ID_TYPEDEF:
 				{
-					char typedefs[4096];
-					char name[1024];
 					s += skip_spaces(s);
-					TRACE_DEBUG("Builtin typedef: '" << s << "'");
-					s += read_block(s, typedefs, sizeof(typedefs), 0, ';');
-					parse_typedef(typedefs);
+					const char *begin = s;
+					s += read_block(s, NULL, 0, 0, ';');
+					Span_t body(begin, s - begin);
+					if (body.size > 0 && *(s - 1) == ';') body.size--;
+					TRACE_DEBUG("Builtin typedef: '" << body << "'");
+					parse_typedef(body);
 				}
 				break;
+				case ID_BITSET:
 				case ID_STRUCT:
 				{
-					char name[1024];
-					s += read_name(s, name, sizeof(name));
+					Span_t name;
+					s += read_span(s, name);
+
+					/** inheritance : struct X : Base { (or X:Base) */
+					for (int k = 0; k < name.size; ++k)
+					{
+						if (name.str[k] != ':') continue;
+						if (k + 1 < name.size && name.str[k + 1] == ':') { k++; continue; }
+						s = name.str + k;
+						name.size = k;
+						break;
+					}
+					int base = -1;
+					if (get_symbol(s) == ':')
+					{
+						s += expect_symbol(s, ':');
+						const char *b = s + skip_spaces(s);
+						const char *e = b;
+						while (*e && *e != '{' && *e != ';') e++;
+						s = b + parse_type_spec(b, e, base);
+					}
+
+					/** forward declaration : struct X; */
+					if (get_symbol(s) == ';')
+					{
+						forward_struct(name);
+						s += expect_symbol(s, ';');
+						break;
+					}
+
 					s += expect_symbol(s, '{');
-					uint size = strlen(s) + 1;
-					char *dest = (char*)N_ALLOCATE(char,size);
-					memset(dest, 0x0, sizeof(char) * size);
 
+					/** 
+					 * the body is parsed in place : (offset, length) over src,
+					 * read_block() only measure it (dest == NULL)
+					 */
 					TRACE_DEBUG("struct read_block()");
-					s += read_block(s, dest, size, 0, '}');
-					parse_struct(b_hash, name, dest);
-					N_DEALLOCATE(dest);
+					const char *body = s + skip_spaces(s);
+					s += read_block(s, NULL, 0, 0, '}');
+					const char *end = s;
+					if (end > body && *(end - 1) == '}') end--;
+					parse_struct(b_hash, name, Span_t(body, end - body), pending, -1,
+						base);
+
+					if (*s == ';') s++;
+				}
+				break;
+
+				case ID_BITMASK:
+				case ID_ENUM:
+				{
+					Span_t name;
+					s += read_span(s, name);
+					s += expect_symbol(s, '{');
+
+					const char *body = s + skip_spaces(s);
+					s += read_block(s, NULL, 0, 0, '}');
+					const char *end = s;
+					if (end > body && *(end - 1) == '}') end--;
+					parse_enum(b_hash, name, Span_t(body, end - body), pending);
+
+					if (*s == ';') s++;
+				}
+				break;
+
+				case ID_UNION:
+				{
+					Span_t name;
+					s += read_span(s, name);
+
+					/** switch ( discriminator type ) */
+					Span_t keyword;
+					s += read_span(s, keyword);
+					if (!keyword.equals("switch"))
+						TRACE_ERROR("union " << name << ": 'switch' expected");
+					s += skip_spaces(s);
+					const char *disc = s;
+					s += read_block(s, NULL, 0, '(', ')');
+					int node;
+					parse_type_spec(disc + 1, s - 1, node);
+
+					s += expect_symbol(s, '{');
+					const char *body = s + skip_spaces(s);
+					s += read_block(s, NULL, 0, 0, '}');
+					const char *end = s;
+					if (end > body && *(end - 1) == '}') end--;
+					parse_struct(b_hash, name, Span_t(body, end - body), pending, node);
+
+					if (*s == ';') s++;
+				}
+				break;
+
+				case ID_INTERFACE:
+				{
+					Span_t name;
+					s += read_span(s, name);
+
+					/** base(s) : interface X : A, B { (or X:A) */
+					for (int k = 0; k < name.size; ++k)
+					{
+						if (name.str[k] != ':') continue;
+						if (k + 1 < name.size && name.str[k + 1] == ':') { k++; continue; }
+						s = name.str + k;
+						name.size = k;
+						break;
+					}
+
+					/** forward declaration : interface X; */
+					if (get_symbol(s) == ';')
+					{
+						s += expect_symbol(s, ';');
+						break;
+					}
+
+					Span_t bases;
+					if (get_symbol(s) == ':')
+					{
+						s += expect_symbol(s, ':');
+						s += skip_spaces(s);
+						bases.str = s;
+						while (*s && *s != '{') s++;
+						bases.size = s - bases.str;
+					}
+
+					/** the body may hold block(s) : count the braces */
+					s += skip_spaces(s);
+					const char *body = s + 1;
+					s += read_block(s, NULL, 0, '{', '}');
+					const char *end = s;
+					if (end > body && *(end - 1) == '}') end--;
+					parse_interface(name, bases, Span_t(body, end - body));
 
 					if (*s == ';') s++;
 				}
@@ -769,12 +4159,18 @@ int IdlParser::parse(const char* src)
 
 				case ID_MODULE:
 				{
-					char name[1024];
-					s += read_name(s, name, sizeof(name));
+					Span_t name;
+					s += read_span(s, name);
 					TRACE_DEBUG( "module name : " << name );
-					nameSpace = name;
+					int previous = open_module(name);
+
+					s += expect_symbol(s, '{');
+					s += parse(s); // up to the closing '}'
 
-					s += parse(s);
+					/** back to the enclosing module */
+					scope = previous;
+					nameSpace = modules[scope].nameSpace;
+					if (*s == ';') s++;
 				}
 				break;
 			}
@@ -983,12 +4379,26 @@ char *IdlParser::preprocessor(const char* path,
 				char value[1024] = {0};
 				s += read_name(s,name,sizeof(name));
 
-				// TODO : handle pragma:
-				// 'keylist' : <data-type-name> <key>*
-				// 'cats', 'stac'
-				// http://download.ist.adlinktech.com/docs/Vortex/html/ospl/IDLPreProcGuide/keys.html
 				s += read_block(s,value,sizeof(value),0,'\n');
 
+				// 'keylist' : <data-type-name> <key>*
+				if(define_ok && !strcmp(name,"keylist"))
+				{
+					String input(value);
+					input.replace(","," ");
+					String_v mar = Explode( input, ' ' );
+					if(mar.size() >= 1)
+					{
+						Keylist_t keylist;
+						keylist.type = mar[0];
+						for(int i = 1; i < mar.size(); ++i)
+							keylist.keys.push_back( mar[i] );
+						MY_DEBUG("keylist: " << keylist.type << " " << 
+							keylist.keys.size() << " key(s)");
+						keylists.push_back( keylist );
+					}
+				}
+
 				continue;
 			}
 			// #include -------------------------------------------------------
@@ -1193,13 +4603,10 @@ int Parser::get_symbol(const char *src, const char *symbols)
 // -----------------------------------------------------------------------------
 int Parser::read_name(const char *src, char *dest, int size)
 {
-	MY_DEBUG("read_name(" << src << ")");
-
 	const char *s = src;
+	char *name = dest;
 	s += skip_spaces(s);
 
-	MY_DEBUG("read_name() >> skip_spaces(" << s << ")");
-
 	if (dest == NULL)
 	{
 		error("Parser::read_name(): dest is NULL\n");
@@ -1225,9 +4632,69 @@ int Parser::read_name(const char *src, char *dest, int size)
 
 	*dest = '\0';
 
+	MY_DEBUG("read_name(" << name << ")");
+
+	return s - src;
+}
+
+// -----------------------------------------------------------------------------
+int Parser::read_span(const char *src, Span_t& dest)
+{
+	const char *s = src;
+	s += skip_spaces(s);
+
+	if (*s == '\0' || (isalpha(*s) == 0 && strchr("_:", *s) == NULL))
+	{
+		error("Parser::read_span(): bad name: '%c'\n", *s);
+	}
+
+	dest.str = s;
+	while (*s && (isdigit(*s) || isalpha(*s) ||
+		strchr("_:", *s)))
+	{
+		s++;
+	}
+	dest.size = s - dest.str;
+
+	MY_DEBUG("read_span(" << dest << ")");
+
 	return s - src;
 }
 
+// -----------------------------------------------------------------------------
+Span_t Parser::rfind_name(const char *begin, const char *end)
+{
+	/** last name of [begin, end) ie.: "@key ::Mod1::T_Char  a " > "a" */
+	const char *e = end;
+	while (e > begin && strchr(" \n", *(e - 1))) e--;
+	const char *b = e;
+	while (b > begin && (isdigit(*(b - 1)) || isalpha(*(b - 1)) ||
+		strchr("_:", *(b - 1))))
+	{
+		b--;
+	}
+	return Span_t(b, e - b);
+}
+
+// -----------------------------------------------------------------------------
+hash_t Parser::span_hash(const Span_t& span)
+{
+	/** names are short, hash them from the stack : no allocation */
+	char buf[256];
+	int size = span.size < (int)sizeof(buf) ? span.size : (int)sizeof(buf) - 1;
+	if (size < 0) size = 0;
+	memcpy(buf, span.str, size);
+	buf[size] = '\0';
+	return getHash(buf);
+}
+
+// -----------------------------------------------------------------------------
+String Parser::span2String(const Span_t& span)
+{
+	if (span.empty()) return String();
+	return String(std::string(span.str, span.size).c_str());
+}
+
 // -----------------------------------------------------------------------------
 int Parser::read_digit(const char *src, char *dest, int size)
 {
@@ -1342,13 +4809,9 @@ int Parser::read_block(
 		s++;
 	}
 
-	// if zero target
-	if (dest == NULL)
-		size = 1000000;
-
 	while (*s)
 	{
-		if (--size < 1)
+		if (dest && --size < 1)
 		{
 			error("Parser::read_block(): buffer overflow\n");
 		}
@@ -1477,6 +4940,296 @@ String IdlParser::var2Real(const Variable_t& v)
 	return s;
 }
 
+// -----------------------------------------------------------------------------
+static const char* __cxx_name[LAST_TYPE] = {
+	"void", "uint8_t", "int8_t", "int16_t", "int16_t", "int32_t", "int32_t",
+	"int32_t", "int64_t", "int64_t", "uint8_t", "uint16_t", "uint32_t",
+	"uint64_t", "bool", "bool", "char", "float", "string", "double", "vector",
+	"", "idl_map"
+};
+
+void IdlParser::cxx_support(std::ostream& os)
+{
+	/**
+	 * generated once, before the types : flat sorted map storage (see
+	 * type_layout()), keys and values in two arrays, no node
+	 */
+	const char* ns = pmr ? "std::pmr::" : "std::";
+	os << "template <class K, class V, uint32_t N> struct idl_bounded_map\n{\n"
+		"\tuint32_t count;\n\tK keys[N];\n\tV values[N];\n};\n\n";
+	os << "template <class K, class V> struct idl_map\n{\n"
+		"\t" << ns << "vector<K> keys; // sorted\n"
+		"\t" << ns << "vector<V> values;\n";
+	if ( pmr )
+	{
+		os << "\tusing allocator_type = std::pmr::polymorphic_allocator<char>;\n"
+			"\tidl_map() {}\n"
+			"\texplicit idl_map(const allocator_type& alloc) : keys(alloc), values(alloc) {}\n"
+			"\tidl_map(const idl_map& o, const allocator_type& alloc) :\n"
+			"\t\tkeys(o.keys, alloc), values(o.values, alloc) {}\n";
+	}
+	os << "};\n";
+
+	/** OPT_PMR : an array member is copied in the constructor body (see cxx_allocator()) */
+	if ( pmr )
+	{
+		os << "\ntemplate <class T> inline void idl_copy(T& d, const T& s) { d = s; }\n"
+			"template <class T, uint32_t N> inline void idl_copy(T (&d)[N], const T (&s)[N])\n"
+			"{\n\tfor (uint32_t i = 0; i < N; ++i) idl_copy(d[i], s[i]);\n}\n";
+	}
+}
+
+void IdlParser::cxx_type(int node, int scope, std::ostream& os)
+{
+	/**
+	 * ie.: sequence<string, 4> > std::vector<std::string>
+	 *      (OPT_PMR)           > std::pmr::vector<std::pmr::string>
+	 *      map<long, string>   > idl_map<int32_t, std::string>
+	 *      map<long, long, 8>  > idl_bounded_map<int32_t, int32_t, 8>
+	 * (see cxx_support())
+	 */
+	if ( node < 0 )
+	{
+		os << "void";
+		return;
+	}
+
+	const TypeNode_t& n = nodes[node];
+	const char* ns = pmr ? "std::pmr::" : "std::";
+	if ( n.type == ID_STRING + TYPE_SPACER )
+	{
+		os << ns << "string";
+		return;
+	}
+	if ( n.type == ID_SEQUENCE + TYPE_SPACER )
+	{
+		os << ns << "vector<";
+		cxx_type( n.child, scope, os );
+		os << ">";
+		return;
+	}
+	if ( n.type == ID_MAP + TYPE_SPACER )
+	{
+		os << (n.size < 0 ? "idl_map<" : "idl_bounded_map<");
+		cxx_type( n.child, scope, os );
+		os << ", ";
+		cxx_type( n.mapped, scope, os );
+		if ( n.size >= 0 )
+			os << ", " << n.size;
+		os << ">";
+		return;
+	}
+	if ( n.type >= TYPE_SPACER && n.type < TYPE_SPACER + LAST_TYPE )
+	{
+		os << __cxx_name[n.type - TYPE_SPACER];
+		return;
+	}
+
+	/** user type : full name from the global scope */
+	int id = find_type( n, scope );
+	int in = -1;
+	if ( id >= USER_BASE_SPACER_STRUCT ) in = structs[id - USER_BASE_SPACER_STRUCT].scope;
+	else if ( id >= USER_BASE_SPACER_TYPEDEF ) in = typedefs[id - USER_BASE_SPACER_TYPEDEF].scope;
+	else if ( id >= USER_BASE_SPACER_ENUM ) in = enums[id - USER_BASE_SPACER_ENUM].scope;
+	if ( in > 0 )
+		os << "::" << modules[in].nameSpace;
+	os << "::" << n.name;
+}
+
+int IdlParser::allocates(int node, int scope)
+{
+	/** the C++ type (see cxx_type()) uses the heap : string, vector, map */
+	while ( node >= 0 && nodes[node].type < 0 )
+	{
+		int id = find_type( nodes[node], scope );
+		if ( id >= USER_BASE_SPACER_STRUCT )
+		{
+			const Struct_t& str = structs[id - USER_BASE_SPACER_STRUCT];
+			if ( str.disc >= 0 )
+				return 0; // union : no allocator-aware constructor, see union_allocates()
+			for ( int j = 0; j < str.fields.size(); ++j )
+				if ( allocates( str.fields[j].type.node, str.fields[j].scope ) )
+					return 1;
+			return 0;
+		}
+		if ( id < USER_BASE_SPACER_TYPEDEF )
+			return 0; // enum, unknown
+		const Typedef_t& td = typedefs[id - USER_BASE_SPACER_TYPEDEF];
+		node = td.node;
+		scope = td.scope;
+	}
+	if ( node >= 0 && nodes[node].type == ID_MAP + TYPE_SPACER )
+	{
+		const TypeNode_t& n = nodes[node];
+		return n.size < 0 || allocates( n.child, scope ) || allocates( n.mapped, scope );
+	}
+	return node >= 0 && (nodes[node].type == ID_STRING + TYPE_SPACER ||
+		nodes[node].type == ID_SEQUENCE + TYPE_SPACER);
+}
+
+int IdlParser::union_allocates(int node, int scope)
+{
+	/** a union with a branch which allocates (string, array of string, ...) */
+	while ( node >= 0 && nodes[node].type < 0 )
+	{
+		int id = find_type( nodes[node], scope );
+		if ( id >= USER_BASE_SPACER_STRUCT )
+		{
+			const Struct_t& str = structs[id - USER_BASE_SPACER_STRUCT];
+			if ( str.disc < 0 )
+				return 0;
+			for ( int j = 0; j < str.fields.size(); ++j )
+				if ( allocates( str.fields[j].type.node, str.fields[j].scope ) ||
+					inline_allocates( str.fields[j] ) )
+					return 1;
+			return 0;
+		}
+		if ( id < USER_BASE_SPACER_TYPEDEF )
+			return 0;
+		const Typedef_t& td = typedefs[id - USER_BASE_SPACER_TYPEDEF];
+		node = td.node;
+		scope = td.scope;
+	}
+	return 0;
+}
+
+int IdlParser::inline_allocates(const Variable_t& v)
+{
+	/**
+	 * element(s) stored inline which allocate : array of string, bounded map
+	 * of string, union with a string branch, ... the resource can't be given
+	 * to them (OPT_PMR)
+	 */
+	if ( union_allocates( v.type.node, v.scope ) )
+		return 1;
+
+	int array = v.dims;
+	int node = v.type.node;
+	int scope = v.scope;
+	while ( node >= 0 && nodes[node].type < 0 )
+	{
+		int id = find_type( nodes[node], scope );
+		if ( id < USER_BASE_SPACER_TYPEDEF || id >= USER_BASE_SPACER_STRUCT )
+			break;
+		const Typedef_t& td = typedefs[id - USER_BASE_SPACER_TYPEDEF];
+		array |= td.dims; // typedef string A[4]
+		node = td.node;
+		scope = td.scope;
+	}
+	if ( array )
+		return allocates( node, scope ) || union_allocates( node, scope );
+	if ( node < 0 || nodes[node].type != ID_MAP + TYPE_SPACER || nodes[node].size < 0 )
+		return 0;
+	const TypeNode_t& n = nodes[node];
+	return allocates( n.child, scope ) || union_allocates( n.child, scope ) ||
+		allocates( n.mapped, scope ) || union_allocates( n.mapped, scope );
+}
+
+int IdlParser::cxx_array(const Variable_t& v)
+{
+	/** the C++ member is a C array (field or typedef dimension(s)) */
+	if ( v.dims )
+		return 1;
+
+	int node = v.type.node;
+	int scope = v.scope;
+	while ( node >= 0 && nodes[node].type < 0 )
+	{
+		int id = find_type( nodes[node], scope );
+		if ( id < USER_BASE_SPACER_TYPEDEF || id >= USER_BASE_SPACER_STRUCT )
+			return 0;
+		const Typedef_t& td = typedefs[id - USER_BASE_SPACER_TYPEDEF];
+		if ( td.dims )
+			return 1;
+		node = td.node;
+		scope = td.scope;
+	}
+	return 0;
+}
+
+void IdlParser::cxx_allocator(int i, std::ostream& os)
+{
+	/**
+	 * OPT_PMR : members of an allocator-aware struct, the resource is given
+	 * to every string, vector, map (and nested struct) member, so a decoder
+	 * builds a whole sample in one arena : T sample(&monotonic_resource);
+	 * the other members are value-initialized.
+	 * ie.: struct S { string s; long l; };
+	 *   using allocator_type = std::pmr::polymorphic_allocator<char>;
+	 *   S() : S(allocator_type()) {}
+	 *   explicit S(const allocator_type& alloc) : s(alloc), l() {}
+	 *   S(const S& o, const allocator_type& alloc) : s(o.s, alloc), l(o.l) {}
+	 * an array can't be copy-initialized : it is copied in the body
+	 * (idl_copy(), see cxx_support()).
+	 * an array (or a bounded map) of allocating element(s), or a union with
+	 * an allocating branch, is an error : they would silently use the
+	 * default resource
+	 */
+	const Struct_t& str = structs[i];
+	if ( !pmr || str.lazy || str.forward || str.disc >= 0 ||
+		str.type == ID_BITSET + BASE_SPACER )
+		return;
+
+	int j;
+	int found = 0;
+	for ( j = 0; j < str.fields.size(); ++j )
+	{
+		const Variable_t& v = str.fields[j];
+		found |= allocates( v.type.node, v.scope );
+		if ( inline_allocates(v) )
+			TRACE_ERROR("OPT_PMR : " << str.nameSpan << "::" << v.nameSpan <<
+				" : inline element(s) (array, bounded map, union) can't use the resource");
+	}
+	if ( !found )
+		return; // no allocation : the default members are kept
+
+	os << "\tusing allocator_type = std::pmr::polymorphic_allocator<char>;\n";
+	os << "\t" << str.nameSpan << "() : " << str.nameSpan << "(allocator_type()) {}\n";
+
+	const char* sep = " : ";
+	os << "\texplicit " << str.nameSpan << "(const allocator_type& alloc)";
+	for ( j = 0; j < str.fields.size(); ++j )
+	{
+		const Variable_t& v = str.fields[j];
+		const int alloc = !inline_allocates(v) && allocates( v.type.node, v.scope );
+		os << sep << v.nameSpan << (alloc ? "(alloc)" : "()");
+		sep = ", ";
+	}
+	os << " {}\n";
+
+	sep = " : ";
+	int arrays = 0;
+	os << "\t" << str.nameSpan << "(const " << str.nameSpan <<
+		"& o, const allocator_type& alloc)";
+	for ( j = 0; j < str.fields.size(); ++j )
+	{
+		const Variable_t& v = str.fields[j];
+		if ( cxx_array(v) )
+		{
+			arrays++;
+			continue;
+		}
+		os << sep << v.nameSpan << "(o." << v.nameSpan;
+		if ( !inline_allocates(v) && allocates( v.type.node, v.scope ) )
+			os << ", alloc";
+		os << ")";
+		sep = ", ";
+	}
+	if ( !arrays )
+	{
+		os << " {}\n";
+		return;
+	}
+	os << "\n\t{\n";
+	for ( j = 0; j < str.fields.size(); ++j )
+	{
+		const Variable_t& v = str.fields[j];
+		if ( cxx_array(v) )
+			os << "\t\tidl_copy(" << v.nameSpan << ", o." << v.nameSpan << ");\n";
+	}
+	os << "\t}\n";
+}
+
 String IdlParser::optimize(const char* filename, const String& code)
 {
 	int i,j, found_entry_point=0;
@@ -1503,19 +5256,94 @@ String IdlParser::optimize(const char* filename, const String& code)
 
 	// parse code and store all supported info
 	parse(rdata);
+
+	// lazy : only parse the bodies of the types used by the topics
+	if ( lazy )
+	{
+		int_v roots = prune_topics ? topics() : all_types();
+		for ( int i = 0; i < roots.size(); ++i )
+			require( roots[i] );
+	}
+
+	// second pass : resolve all type names
+	resolve();
+
+	// only keep the types used by the topics
+	if ( prune_topics )
+		prune( topics() );
+
+	if ( report_layout )
+		report( std::cout );
 	
 	str = user_optimize();
 
 	//ne_assert( defines.size() );
 
-	N_DEALLOCATE( rdata );
+	// the model may reference the source(s) (Span_t) : keep them alive
+	if ( source )
+		sources.push_back( source );
+	source = rdata;
+
+	return str;
+}
+
+// -----------------------------------------------------------------------------
+struct GenerateContext_t
+{
+	IdlParser* parser;
+	const int_v* vertexes;
+	String_v* code;
+};
+
+static void generate_fn(void* ctx, int i)
+{
+	GenerateContext_t* g = (GenerateContext_t*)ctx;
+	int vertex = (*g->vertexes)[i];
+	if ( !g->parser->graph.used[vertex] )
+		return; // pruned
+	(*g->code)[vertex] = g->parser->user_generate( g->parser->graph_id(vertex) );
+}
+
+String IdlParser::generate()
+{
+	/**
+	 * level by level : all the types of a level only depend on lower levels,
+	 * so they are generated at the same time on the worker thread(s)
+	 */
+	String_v code;
+	String str;
+	int i, j;
+
+	code.resize( graph.order.size() );
+
+	for (i = 0; i < graph.levels.size(); ++i)
+	{
+		GenerateContext_t ctx = { this, &graph.levels[i], &code };
+		parallel( graph.levels[i].size(), generate_fn, &ctx, threads );
+	}
+
+	for (i = 0; i < graph.levels.size(); ++i)
+	{
+		for (j = 0; j < graph.levels[i].size(); ++j)
+		{
+			str << code[ graph.levels[i][j] ];
+		}
+	}
 
 	return str;
 }
 
-IdlParser::IdlParser(const String& file) : 
-	Parser(), code(), defines(), linearize(0), generate_comment(1)
+IdlParser::IdlParser(const String& file, int options) : 
+	Parser(), code(), defines(), linearize(0), generate_comment(1),
+	prune_topics(0), report_layout(0), pmr(0), source(NULL), sources()
 {
+	span_model = (options & OPT_SPAN_MODEL) ? 1 : 0;
+	prune_topics = (options & OPT_PRUNE) ? 1 : 0;
+	lazy = (options & OPT_LAZY) ? 1 : 0;
+	report_layout = (options & OPT_REPORT) ? 1 : 0;
+	reorder = (options & OPT_REORDER) ? 1 : 0;
+	pmr = (options & OPT_PMR) ? 1 : 0;
+
 	char* str = preprocessor(file);
 	code = optimize(file, str);
 	N_DEALLOCATE(str);
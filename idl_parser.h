@@ -21,25 +21,31 @@
  * --------------------------------------
  * int8_t, int16_t, int32_t / int, int64_t
  * uint8_t, uint16_t, uint32_t, uint64_t
+ * unsigned short, unsigned long, unsigned long long, long long
+ * sequence<type[, size]> (nested too), string<size>, map<key, value[, size]>
+ * array >> ie.: "char a[10];" (fields), "typedef long T[4];"
+ * enum (@value, @bit_bound)
+ * union Name switch(type) { case X: ... default: ... }
+ * bitset (bitfield<N[, type]>), bitmask (@position, @bit_bound)
+ * struct inheritance : struct Derived : Base { ... } (flattened)
+ * const type NAME = expression; (folded, usable as a bound : string<N * 2>)
+ * interface Name [: Base] { [oneway] type op([in|out|inout] type name, ...); }
  * 
  * todo(s):
  * --------
  * handle all known type from the standard, eprosima, rti, ...
  * field/variable name must not contain any "type name" >> error
- * array
- * map
- * bitset
- * bitmask
  * 
  * unsupported:
  * ------------
  * In-line nested types are not supported.
  * prama #if is not supported right now.
- * array >> ie.: "char a[10];" (on the todo list)
  * 
  * Note on namespace (Module) :
  * ------------------------------
- * There is a limited support for namespace.
+ * Modules are a scope tree (Parser::modules), nested and reopened modules
+ * are supported. Type names are resolved relative to the current module
+ * (up to the global scope) or absolute ("::A::B::T").
  * 
  * ref(s) :
  * https://www.omg.org/spec/IDL/4.2/PDF
@@ -60,6 +66,10 @@
 
 #include <vector>
 #include <map>
+#if __cplusplus >= 201103L
+#include <thread>
+#include <atomic>
+#endif
 #include "common.h"
 
 #include "str.h"
@@ -68,6 +78,8 @@
 
 #define N_VECTOR(type_) typedef Vector<type_> type_##_v;
 
+#define MAX_ARRAY_DIM	4	// up to 4 dimension(s) for an array field
+
 
 /** 
  * pos/index must equal pos/index in structure : __internal_hash 
@@ -96,6 +108,7 @@ enum TypeAndCommande_e {
 	ID_DOUBLE,
 	ID_SEQUENCE,
 	ID_CONST,
+	ID_MAP,
 
 	LAST_TYPE,
 
@@ -104,34 +117,270 @@ enum TypeAndCommande_e {
 	ID_STRUCT = BASE_START,
 	ID_MODULE,
 	ID_TYPEDEF,
+	ID_ENUM,
+	ID_UNION,
+	ID_BITSET,
+	ID_BITMASK,
+	ID_INTERFACE,
 	LAST_BASE,
 
 	TYPE_SPACER		= 1024,	// up to 1024 type before overflow
 	BASE_SPACER		= 4096,	// up to 4096 base command before overflow
 	
+	USER_BASE_SPACER_ENUM	= 6144,	// up to 2048 enum
 	USER_BASE_SPACER_TYPEDEF= 8192,	// up to 8192 typedef
 	USER_BASE_SPACER_STRUCT= 16384	// up to 16384 struct
 };
 
+/**
+ * Options given to IdlParser(file, options)
+ */
+enum IdlOption_e {
+	OPT_NONE		= 0,
+	OPT_SPAN_MODEL	= 1 << 0,	// model names are Span_t only (no String copy)
+	OPT_PRUNE		= 1 << 1,	// generate only the types used by the topics
+	OPT_LAZY		= 1 << 2,	// parse a body the first time its type is required
+	OPT_REPORT		= 1 << 3,	// print the layout / cost of each type (Parser::report())
+	OPT_REORDER		= 1 << 4,	// in-memory members by alignment (Struct_t::order)
+	OPT_PMR			= 1 << 5	// generated types use std::pmr (IdlParser::cxx_allocator())
+};
+
+/**
+ * Classes of a type, computed once by Parser::classify() after the layout :
+ * a generator picks its fast path with a bit test, no field walk.
+ * unbounded : !CLASS_BOUNDED
+ */
+enum TypeClass_e {
+	CLASS_NONE		= 0,
+	CLASS_FIXED		= 1 << 0,	// fixed in-memory size, no allocation
+	CLASS_BOUNDED	= 1 << 1,	// every string, sequence, map is bounded
+	/**
+	 * trivially serializable (a single copy) in an encoding (Encoding_e) :
+	 * fixed, no padding, no optional, union or @mutable, every holder is its
+	 * wire size (XCDR1 : enum on 4 bytes) and no header (XCDR2 : @final)
+	 * the bit of an encoding : CLASS_TRIVIAL_XCDR1 << e
+	 */
+	CLASS_TRIVIAL_XCDR1	= 1 << 2,
+	CLASS_TRIVIAL_XCDR2	= 1 << 3,
+	CLASS_TRIVIAL		= CLASS_TRIVIAL_XCDR1 | CLASS_TRIVIAL_XCDR2	// mask
+};
+
+/**
+ * Annotation(s) on a type or a member : @name[(value)]
+ * read once by Parser::parse_annotations(), then only bits are tested.
+ * https://www.omg.org/spec/DDS-XTypes/1.3/PDF (7.3.1.2.1)
+ */
+enum Annotation_e {
+	ANN_NONE			= 0,
+	// member
+	ANN_KEY				= 1 << 0,	// @key
+	ANN_OPTIONAL		= 1 << 1,	// @optional
+	ANN_EXTERNAL		= 1 << 2,	// @external
+	ANN_MUST_UNDERSTAND	= 1 << 3,	// @must_understand
+	ANN_ID				= 1 << 4,	// @id(N)
+	ANN_HASHID			= 1 << 5,	// @hashid, @hashid("name")
+	ANN_VALUE			= 1 << 6,	// @value(N) (enumerator)
+	ANN_POSITION		= 1 << 7,	// @position(N) (bitmask flag)
+	// type
+	ANN_FINAL			= 1 << 8,	// @final, @extensibility(FINAL)
+	ANN_APPENDABLE		= 1 << 9,	// @appendable, @extensibility(APPENDABLE)
+	ANN_MUTABLE			= 1 << 10,	// @mutable, @extensibility(MUTABLE)
+	ANN_NESTED			= 1 << 11,	// @nested
+	ANN_TOPIC			= 1 << 12,	// @topic
+	ANN_AUTOID_HASH		= 1 << 13,	// @autoid(HASH), def : SEQUENTIAL
+	ANN_BIT_BOUND		= 1 << 14,	// @bit_bound(N) (enum, bitmask)
+	// layout (struct, member)
+	ANN_ALIGN			= 1 << 15,	// @align(N), ie.: 64 : a cache line
+	ANN_COLD			= 1 << 16,	// @cold : member in the separate tail
+
+	ANN_EXTENSIBILITY	= ANN_FINAL | ANN_APPENDABLE | ANN_MUTABLE
+};
+
+/**
+ * Data representation of a serialized sample, see Struct_t::max_size
+ * https://www.omg.org/spec/DDS-XTypes/1.3/PDF (7.4.3)
+ */
+enum Encoding_e {
+	XCDR1			= 0,	// classic CDR, PL_CDR (@mutable), alignment up to 8
+	XCDR2			= 1,	// DHEADER, EMHEADER (@mutable), alignment up to 4
+	ENCODINGS
+};
+
+/**
+ * Direction of an operation parameter (see Operation_t)
+ */
+enum ParamDir_e {
+	PARAM_NONE		= 0,	// not a parameter (field)
+	PARAM_IN		= 1 << 0,
+	PARAM_OUT		= 1 << 1,
+	PARAM_INOUT		= PARAM_IN | PARAM_OUT
+};
+
+/**
+ * A piece of the (retained) source buffer, not null terminated.
+ * ie.: "struct foo_t { ... }"
+ *              ^    ^
+ *              str  str + size
+ */
+struct Span_t
+{
+	Span_t() : str(NULL), size(0) {}
+	Span_t(const char* s, int n) : str(s), size(n) {}
+	const char* str;
+	int size;
+
+	inline bool empty() const { return size <= 0; }
+	inline bool equals(const char* s) const
+	{
+		return s && (int)strlen(s) == size && !strncmp(str, s, size);
+	}
+}; // Span_t
+N_VECTOR(Span_t)
+
+inline std::ostream& operator<<(std::ostream& os, const Span_t& span)
+{
+	return os.write(span.str, span.size);
+}
+
+/**
+ * Annotation(s) read before a declaration, see Annotation_e.
+ * ie.: @key @id(3) long a; > flags: ANN_KEY | ANN_ID, id: 3
+ */
+struct Annotation_t
+{
+	Annotation_t() : flags(ANN_NONE), id(-1), hashid(), value(0), bit_bound(32),
+		align(0) {}
+	int flags;		// ANN_xxx
+	int id;			// @id(N), -1 if none
+	Span_t hashid;	// @hashid("name"), empty : the member name
+	int value;		// @value(N), @position(N)
+	int bit_bound;	// @bit_bound(N)
+	int align;		// @align(N), 0 if none
+}; // Annotation_t
+
+/**
+ * Key > index table, see Parser::build_table() :
+ * member id > field of a @mutable struct (an unknown member, -1, is skipped
+ * with the length code of its EMHEADER), enum value > enumerator, ...
+ * dense       : index[id - base]
+ * perfect hash: index[(id * seed) >> shift], ids[] to reject unknown id(s)
+ */
+struct MemberTable_t
+{
+	MemberTable_t() : base(0), seed(0), shift(0), index(), ids() {}
+	int base;		// smallest member id (dense)
+	uint32_t seed;	// multiplier, 0 : dense table
+	int shift;		// 32 - log2(index.size()) (perfect hash)
+	int_v index;	// field index, -1 : unknown member
+	int_v ids;		// member id of each slot (perfect hash)
+
+	inline int find(int id) const
+	{
+		if ( seed == 0 )
+		{
+			unsigned int slot = (unsigned int)(id - base);
+			return slot < (unsigned int)index.size() ? index[slot] : -1;
+		}
+		unsigned int slot = ((uint32_t)id * seed) >> shift;
+		return ids[slot] == id ? index[slot] : -1;
+	}
+}; // MemberTable_t
+
+struct Enumerator_t
+{
+	Enumerator_t() : hash(0), name(), nameSpan(), value(0) {}
+	hash_t hash;	// hash(name)
+	String name;
+	Span_t nameSpan;
+	int value;		// @value(N), else previous + 1 (bitmask : bit position)
+}; // Enumerator_t
+N_VECTOR(Enumerator_t)
+
+/**
+ * enum (and its enumerators), parsed by Parser::parse_enum()
+ * ie.: @bit_bound(16) enum Color { RED, @value(4) GREEN, BLUE };
+ *      values: RED 0, GREEN 4, BLUE 5  min: 0 max: 5 bytes: 2
+ * a bitmask is an Enum_t of type ID_BITMASK, the values are bit positions :
+ * ie.: @bit_bound(8) bitmask Flags { A, @position(4) B };
+ *      values: A 0 (mask 0x01), B 4 (mask 0x10)  bytes: 1
+ */
 struct Enum_t
 {
-	Enum_t() : hash(0), type(0), name(), nameSpace(), body() {}
+	Enum_t() : hash(0), type(0), name(), nameSpace(), body(), nameSpan(),
+		scope(0), flags(ANN_NONE), bit_bound(32), bytes(4), values(), min(0),
+		max(0), contiguous(true), byValue(), byName() {}
 	hash_t hash; // hash(name)
 	int type;		// check built-in base
 	String name;
 	String nameSpace;
 	String body;
+	Span_t nameSpan;
+	int scope;			// declared in (index in Parser::modules)
+	int flags;			// annotation(s), see Annotation_e
+	int bit_bound;		// @bit_bound(N), def : 32
+	int bytes;			// holder size : 1, 2, 4 (or 8 : bitmask) byte(s) (bit_bound)
+	Enumerator_t_v values; // declaration order
+	int min, max;		// smallest / biggest value
+	bool contiguous;	// all values in [min, max] : valid(v) is a single compare
+	MemberTable_t byValue; // value > enumerator (dense, else perfect hash)
+	MemberTable_t byName;  // Parser::name_hash(name) > enumerator
+
+	inline bool valid(int v) const
+	{
+		if ( contiguous )
+			return (unsigned int)(v - min) <= (unsigned int)(max - min);
+		return byValue.find(v) >= 0;
+	}
 }; // Enum_t 
 N_VECTOR(Enum_t)
+/**
+ * Node of a type tree, all nodes are stored in Parser::nodes.
+ * ie.: sequence<sequence<long, 4>, N>
+ *      [0] ID_SEQUENCE size: -1 sizeName: N child: 1
+ *      [1] ID_SEQUENCE size: 4 child: 2
+ *      [2] ID_LONG
+ * ie.: map<string, T, 8>
+ *      [0] ID_MAP size: 8 child: 1 mapped: 2
+ *      [1] ID_STRING
+ *      [2] T
+ */
+struct TypeNode_t
+{
+	TypeNode_t() : type(-1), hash(0), name(), scope(), absolute(false),
+		size(-1), sizeName(), child(-1), mapped(-1) {}
+	int type;		// built-in type (+TYPE_SPACER), -1 for a user type
+	hash_t hash;	// hash(name) without scope
+	Span_t name;	// name without scope, ie.: "T_Char"
+	Span_t scope;	// scope as written, ie.: "Mod1" for "::Mod1::T_Char"
+	bool absolute;	// scope start with "::"
+	int size;		// bound of a template (sequence<T, N>, string<N>), -1 if none
+	Span_t sizeName;// bound given as a constant expression (folded in size)
+	int child;		// element type (index in Parser::nodes), -1 if none
+					// map : key type
+	int mapped;		// map : value type (index in Parser::nodes), -1 if none
+}; // TypeNode_t
+N_VECTOR(TypeNode_t)
+
 struct Typedef_t
 {
-	Typedef_t() : hash(0), type(0), name(), baseName(), nameSpace(), size(-1) {}
+	Typedef_t() : hash(0), type(0), name(), baseName(), nameSpace(), size(-1),
+		baseHash(0), nameSpan(), node(-1), dims(0), array(), scope(0), body(),
+		lazy(false), classes(CLASS_NONE) {}
 	hash_t hash; 		// hash(name)
 	int type;			// base type
 	String name;		// new type name
 	String baseName;	// base type name
 	String nameSpace;
 	int size; /** if type == SEQ > sequence with defined size, else 0 */
+	hash_t baseHash;	// hash(baseName), used to follow the typedef chain
+	Span_t nameSpan;	// new type name inside the source
+	int node;			// type tree as written (index in Parser::nodes)
+	int dims;			// array dimension(s), ie.: "typedef long A[2][3]" > 2
+	int array[MAX_ARRAY_DIM]; // array size(s), ie.: "A[2][3]" > 2, 3
+	int scope;			// declared in (index in Parser::modules)
+	Span_t body;		// typedef body inside the source (without ';')
+	bool lazy;			// body not parsed yet (see Parser::require())
+	int classes;		// see TypeClass_e
 	/** ie.:
 	 * typedef char T_Char
 	 *         ^    ^
@@ -140,37 +389,264 @@ struct Typedef_t
 	 */
 }; // Typedef_t 
 N_VECTOR(Typedef_t)
+/**
+ * A module is a node of the scope tree, Parser::modules[0] is the global
+ * scope. A reopened module is the same node.
+ * ie.: module A { module B { struct T {}; }; };
+ *      [0] ''  scopes: A > 1
+ *      [1] 'A' scopes: B > 2
+ *      [2] 'B' types: T > USER_BASE_SPACER_STRUCT + x
+ */
 struct Module_t
 {
-	Module_t() : hash(0), type(0), name(), body() {}
+	Module_t() : hash(0), type(0), name(), body(), nameSpan(), nameSpace(),
+		parent(-1), scopes(), types(), consts() {}
 	hash_t hash; // hash(name)
 	int type;		// check built-in base
 	String name;
 	String body;
+	Span_t nameSpan;
+	String nameSpace;		// full name, ie.: "A::B"
+	int parent;				// index in Parser::modules, -1 for the global scope
+	Map<hash_t, int> scopes;// hash(name) > child module (index in Parser::modules)
+	Map<hash_t, int> types;	// hash(name) > type (see Parser::is_user_base)
+	Map<hash_t, int> consts;// hash(name) > constant (index in Parser::consts)
 }; // Module_t 
 N_VECTOR(Module_t)
+/**
+ * Value of a constant expression, see Parser::fold()
+ */
+struct ConstValue_t
+{
+	ConstValue_t() : integer(0), real(0), is_real(false), text() {}
+	int64_t integer;	// integer, char, boolean (0 / 1), enumerator
+	double real;		// float, double (is_real)
+	bool is_real;
+	Span_t text;		// string, without the quotes
+}; // ConstValue_t
+
+/**
+ * const type NAME = expression;
+ * the expression is folded once it is declared (IDL : declared before use)
+ * ie.: const long N = 4; const long M = (N << 2) + 1; > M: 17
+ */
+struct Const_t
+{
+	Const_t() : hash(0), name(), nameSpace(), nameSpan(), node(-1), scope(0),
+		expr(), value() {}
+	hash_t hash;		// hash(name)
+	String name;
+	String nameSpace;
+	Span_t nameSpan;
+	int node;			// type tree (index in Parser::nodes)
+	int scope;			// declared in (index in Parser::modules)
+	Span_t expr;		// expression as written
+	ConstValue_t value;	// folded value
+}; // Const_t
+N_VECTOR(Const_t)
+
+/**
+ * Path to a key member, from a topic struct.
+ * ie.: #pragma keylist foo_t a.b
+ *      fields: index of 'a' in foo_t, index of 'b' in the type of 'a'
+ *      offset: offset of 'a' in foo_t + offset of 'b' in the type of 'a'
+ */
+struct KeyPath_t
+{
+	KeyPath_t() : path(), fields(), offsets(), offset(-1) {}
+	String path;	// as written, ie.: "a.b"
+	int_v fields;	// field index, one per level
+	int_v offsets;	// byte offset of the field inside its struct, one per level
+	int offset;		// byte offset from the topic, -1 if not fixed
+}; // KeyPath_t
+N_VECTOR(KeyPath_t)
+
+/**
+ * #pragma keylist <data-type-name> <key>*
+ * http://download.ist.adlinktech.com/docs/Vortex/html/ospl/IDLPreProcGuide/keys.html
+ */
+struct Keylist_t
+{
+	Keylist_t() : type(), keys() {}
+	String type;	// data type name as written
+	String_v keys;	// key(s) as written, ie.: "a.b"
+}; // Keylist_t
+N_VECTOR(Keylist_t)
+
 struct Variable_t
 {
 	Variable_t() : hash(0), type(), is_key(false), name(), struct_name(),
-		fromNamespace() {}
+		fromNamespace(), nameSpan(), typeSpan(), dims(0), array(), scope(0),
+		offset(-1), bytes(-1), flags(ANN_NONE), id(-1), emheader(0), bit(-1),
+		bits(0), shift(0), dir(PARAM_NONE), aligned(0) {}
 	hash_t hash;	// hash(name)
 	Typedef_t type;
 	bool is_key;
 	String name;
 	String struct_name;
 	String fromNamespace; /** in case the type is from another namespace */
+	Span_t nameSpan;	// field name inside the source
+	Span_t typeSpan;	// type as written, ie.: "::Mod1::T_Char"
+	int dims;			// array dimension(s), ie.: "a[2][3]" > 2
+	int array[MAX_ARRAY_DIM]; // array size(s), ie.: "a[2][3]" > 2, 3
+	int scope;			// declared in (index in Parser::modules)
+	int offset;			// byte offset in the struct (natural alignment), -1 if not fixed
+	int bytes;			// in-memory size, -1 if not fixed (string, sequence)
+	int flags;			// annotation(s), see Annotation_e
+	int id;				// member id : @id, @hashid, else sequential
+	uint32_t emheader;	// XCDR2 EMHEADER1 (M flag, length code, id) of a @mutable member
+	int bit;			// presence bit (@optional), -1 if none, see Struct_t::optionals
+	int bits;			// bitset : bitfield width, 0 : not a bitfield
+	int shift;			// bitset : bitfield position, mask = ((1 << bits) - 1) << shift
+	int dir;			// operation parameter : PARAM_IN, PARAM_OUT or PARAM_INOUT
+	int aligned;		// @align(N) : minimum alignment, 0 if none
 }; // Variable_t
 N_VECTOR(Variable_t)
 struct Struct_t
 {
-	Struct_t() : hash(0), type(0), name(), nameSpace(), fields() {}
+	Struct_t() : hash(0), type(0), name(), nameSpace(), fields(),
+		nameSpan(), body(), scope(0), forward(false), lazy(false), bytes(-1),
+		align(1), keys(), flags(ANN_NONE), members(), optionals(), disc(-1),
+		labels(), branches(), values(), branch_default(-1), cases(), variant(-1),
+		bits(0), base(-1), inherited(-1), classes(CLASS_NONE), padding(-1),
+		max_size(), min_size(), xcdr_end(), xcdr_done(), order(), saved(0),
+		aligned(0), cold(), tail(-1), tail_bytes(-1), tail_align(1) {}
 	hash_t hash; // hash(name)
 	int type;		// check built-in base
 	String name;
 	String nameSpace;
 	Variable_t_v fields; /** fields / champs */
+	Span_t nameSpan;	// struct name inside the source
+	Span_t body;		// struct body inside the source (without '{' '}')
+	int scope;			// declared in (index in Parser::modules)
+	bool forward;		// only declared (struct X;), not defined yet
+	bool lazy;			// body not parsed yet (see Parser::require())
+	int bytes;			// in-memory size (natural alignment), -1 if not fixed
+	int align;			// in-memory alignment
+	KeyPath_t_v keys;	// key(s) : #pragma keylist, else @key field(s)
+	int flags;			// annotation(s), see Annotation_e
+	MemberTable_t members; // member id > field (@mutable only)
+	/**
+	 * presence bit > field index of the @optional field(s) : the bitmap is
+	 * stored first, (optionals.size() + 31) / 32 uint32_t word(s) at offset 0,
+	 * a fixed size optional field is stored inline (no allocation)
+	 */
+	int_v optionals;
+	/**
+	 * union : switch(disc) { case labels[k]: fields[branches[k]] ... },
+	 * a union is a Struct_t of type ID_UNION, its fields are the branches
+	 * and share the same storage (the biggest one), at 'variant' offset
+	 */
+	int disc;			// discriminator type tree (index in Parser::nodes), -1 : struct
+	Span_t_v labels;	// case label(s) as written
+	int_v branches;		// label > field index
+	int_v values;		// label > value (see Parser::case_table())
+	int branch_default;	// field index of 'default:', -1 if none
+	MemberTable_t cases;// discriminator value > field index
+	int variant;		// byte offset of the branches, -1 if not fixed
+	int bits;			// bitset (type ID_BITSET) : width of all the bitfield(s),
+						// packed in a single 1, 2, 4 or 8 byte(s) word
+	/**
+	 * struct Derived : Base { ... } : the fields of Base are copied first
+	 * (see Parser::inherit()), so the hierarchy is a single field run
+	 */
+	int base;			// base struct type tree (index in Parser::nodes), -1 if none
+	int inherited;		// count of the (first) fields from the base, -1 : not done
+	int classes;		// see TypeClass_e
+	int padding;		// byte(s) lost to the alignment (holes, tail), -1 if not fixed
+	/**
+	 * serialized size per encoding (Encoding_e), alignment included, from
+	 * the start of the stream : a send buffer of max_size[e] never grows
+	 */
+	int max_size[ENCODINGS];	// -1 : unbounded
+	int min_size[ENCODINGS];	// unbounded sequence / string empty, no optional
+	/**
+	 * memo of Parser::xcdr_struct() : length of the struct in the stream by
+	 * (max ? 8 : 0) + start % 8, the padding only depends on the start
+	 * modulo 8. -1 : unbounded
+	 */
+	int xcdr_end[ENCODINGS][16];
+	int xcdr_done[ENCODINGS];	// bit : xcdr_end[e][bit] is computed
+	/**
+	 * OPT_REORDER : in-memory order of the hot fields (index in fields), by
+	 * decreasing alignment; the fields (wire, @id) keep the IDL order.
+	 * empty : IDL order (no byte saved, or not fixed)
+	 */
+	int_v order;
+	int saved;			// byte(s) saved by 'order'
+	int aligned;		// @align(N) : minimum alignment (and size multiple), 0 if none
+	/**
+	 * @cold member(s) : stored in a tail allocated apart, the hot block only
+	 * holds a pointer to it; the offset of a cold field is inside the tail.
+	 * the fields (wire) keep the IDL order
+	 */
+	int_v cold;			// field index(es), IDL order
+	int tail;			// offset of the tail pointer, -1 if not fixed (or no cold member)
+	int tail_bytes;		// size of the tail, -1 if not fixed
+	int tail_align;		// alignment of the tail
 }; // Struct_t 
 N_VECTOR(Struct_t)
+/**
+ * [oneway] type name([in|out|inout] type name, ...) [raises(...)];
+ * the request (in, inout) and the reply (return, inout, out) are field runs
+ * marshalled like the fields of a struct.
+ */
+struct Operation_t
+{
+	Operation_t() : hash(0), name(), nameSpan(), result(), oneway(false),
+		params(), request(), reply() {}
+	hash_t hash;		// hash(name)
+	String name;
+	Span_t nameSpan;
+	Variable_t result;	// return value, result.type.node == -1 : void
+	bool oneway;
+	Variable_t_v params;// declaration order, see Variable_t::dir
+	int_v request;		// param(s) sent by the client : in, inout
+	int_v reply;		// param(s) sent back : inout, out (after the result)
+}; // Operation_t
+N_VECTOR(Operation_t)
+
+/**
+ * interface Name [: Base, ...] { operation(s) };
+ * the operations of the base(s) come first, the server dispatches a request
+ * with 'dispatch' : Parser::name_hash(operation name) > operation index
+ */
+struct Interface_t
+{
+	Interface_t() : hash(0), name(), nameSpace(), nameSpan(), scope(0), body(),
+		operations(), inherited(0), dispatch() {}
+	hash_t hash;		// hash(name)
+	String name;
+	String nameSpace;
+	Span_t nameSpan;
+	int scope;			// declared in (index in Parser::modules)
+	Span_t body;		// interface body inside the source (without '{' '}')
+	Operation_t_v operations;
+	int inherited;		// count of the (first) operations from the base(s)
+	MemberTable_t dispatch; // name_hash(name) > operation
+}; // Interface_t
+N_VECTOR(Interface_t)
+
+/**
+ * Dependency graph of the user types, built by Parser::resolve().
+ * A vertex is a struct or a typedef (see Parser::graph_id()),
+ * an edge a > b means a needs b (field type, typedef target).
+ * ie.: struct A { B b; }; struct B { long l; };
+ *      B: level 0, A: level 1 > B must be generated before A
+ */
+struct TypeGraph_t
+{
+	TypeGraph_t() : edges(), level(), levels(), component(), components(),
+		order(), used() {}
+	Vector<int_v> edges;		// vertex > vertex(es) it depends on
+	int_v level;				// vertex > topological level (0: no dependency)
+	Vector<int_v> levels;		// level > vertex(es), level 0 first
+	int_v component;			// vertex > strongly connected component
+	Vector<int_v> components;	// component > vertex(es), dependencies first
+	int_v order;				// all vertex(es), dependencies first
+	int_v used;					// vertex > 1 if reachable from a root (see prune())
+}; // TypeGraph_t
+
 struct UDefine_t
 {
 	UDefine_t() : line() {}
@@ -190,8 +666,21 @@ public:
 		variables(),
 		udefines(),
 		modules(),
-		nameSpace()
-	{	}
+		keylists(),
+		consts(),
+		interfaces(),
+		nodes(),
+		types(),
+		nameSpace(),
+		scope(0),
+		span_model(0),
+		threads(0),
+		lazy(0),
+		reorder(0),
+		annotation()
+	{
+		modules.push_back( Module_t() ); // global scope
+	}
 	virtual ~Parser() {
 		clear();
 	}
@@ -209,6 +698,46 @@ public:
 	// -------------------------------------------------------------------------
 	static int skip_spaces(const char *src);
 	// -------------------------------------------------------------------------
+	static int read_span(const char *src, Span_t& dest);
+	// -------------------------------------------------------------------------
+	static Span_t rfind_name(const char *begin, const char *end);
+	// -------------------------------------------------------------------------
+	static hash_t span_hash(const Span_t& span);
+	// -------------------------------------------------------------------------
+	static String span2String(const Span_t& span);
+	// -------------------------------------------------------------------------
+	static Span_t scope_split(const Span_t& scoped, Span_t& scope);
+	// -------------------------------------------------------------------------
+	static int skip_annotation(const char *src, const char *end, Span_t& name,
+		Span_t& value);
+	int parse_annotations(const char *src, const char *end,
+		Annotation_t& annotation);
+	int annotation_int(const Span_t& name, const Span_t& value, int& result);
+	static int member_hash(const Span_t& name);
+	static int name_hash(const char *name, int size);
+	// -------------------------------------------------------------------------
+	static int read_type_name(const char *src, const char *end, Span_t& type,
+		hash_t& hash);
+	// -------------------------------------------------------------------------
+	int parse_type_spec(const char *src, const char *end, int& node);
+	// -------------------------------------------------------------------------
+	int parse_bound(const char *src, const char *end, TypeNode_t& node);
+	int parse_declarator(const char *src, const char *end, int scope,
+		Span_t& name, int& dims, int* array);
+	static const char* rfind_declarator(const char *begin, const char *end);
+	// -------------------------------------------------------------------------
+	Typedef_t node2Type(int node, int scope);
+	// -------------------------------------------------------------------------
+	Typedef_t id2Type(int id);
+	// -------------------------------------------------------------------------
+	int find_type(const TypeNode_t& node, int scope);
+	// -------------------------------------------------------------------------
+	int find_scope(const Span_t& name, bool absolute, int scope);
+	// -------------------------------------------------------------------------
+	void declare(hash_t hash, int id);
+	// -------------------------------------------------------------------------
+	int open_module(const Span_t& name);
+	// -------------------------------------------------------------------------
 	static int is_builtin_type(const hash_t& hash, int& result);
 	// -------------------------------------------------------------------------
 	static int is_builtin_base(const hash_t& hash, int& result);
@@ -224,16 +753,111 @@ public:
 	// -------------------------------------------------------------------------
 	int read_digit(const char *src, char *dest, int size);
 	// -------------------------------------------------------------------------
-	Variable_t parse_variable(hash_t type, const char* struct_name,  const char *variables, const char* fromNamespace, bool is_key = false);
+	Variable_t parse_variable(int node, const char* struct_name,
+		const Span_t& name, const Span_t& fromNamespace,
+		const Annotation_t& annotation = Annotation_t());
 	// -------------------------------------------------------------------------
 	void parse_command(hash_t command, const char* type, const char *variables);
 	// -------------------------------------------------------------------------
-	void parse_function(hash_t type, const char *name, const char *args,
-			const char *body);
+	void parse_function(Interface_t& itf, int node, const Span_t& name,
+		const Span_t& args, bool oneway);
+	void parse_interface(const Span_t& name, const Span_t& bases,
+		const Span_t& body);
+	int find_interface(const Span_t& name, int scope);
+	int operation(int i, const char *name, int size);
+	// -------------------------------------------------------------------------
+	void parse_struct(const hash_t& type, const Span_t& name,
+		const Span_t& body, const Annotation_t& annotation, int disc = -1,
+		int base = -1);
+	// -------------------------------------------------------------------------
+	void parse_typedef(const Span_t& body);
+	void parse_typedef_body(Typedef_t& typeDef);
+	// -------------------------------------------------------------------------
+	void parse_fields(Struct_t& str);
+	// -------------------------------------------------------------------------
+	void parse_enum(const hash_t& type, const Span_t& name, const Span_t& body,
+		const Annotation_t& annotation);
+	void parse_bitset(Struct_t& str);
+	// -------------------------------------------------------------------------
+	// const declaration and constant expression folding
+	int parse_const(const char *src);
+	int fold(const Span_t& expr, int scope, ConstValue_t& value);
+	int fold_binary(const char *&src, const char *end, int scope, int level,
+		ConstValue_t& value);
+	int fold_unary(const char *&src, const char *end, int scope,
+		ConstValue_t& value);
+	int find_const(const Span_t& name, int scope);
+	int enum_value(int i, const char *name, int size, int& value);
 	// -------------------------------------------------------------------------
-	void parse_struct(const hash_t& type, const char* name, const char* body);
+	// key(s) > index : dense when compact, else multiplicative perfect hash
+	static void build_table(MemberTable_t& table, const int_v& keys);
 	// -------------------------------------------------------------------------
-	void parse_typedef(const char* body);
+	// lazy mode : parse the body of a type and of the types it uses
+	int require(int id);
+	// -------------------------------------------------------------------------
+	void forward_struct(const Span_t& name);
+	// -------------------------------------------------------------------------
+	// second pass : resolve all type names, return the count of error(s)
+	int resolve();
+	int resolve_typedef(int i);
+	int typedef_cycles(int i, int_v& state, int_v& path);
+	int resolve_struct(int i);
+	int resolve_variable(Variable_t& v);
+	// -------------------------------------------------------------------------
+	// dependency graph, see TypeGraph_t
+	void build_graph();
+	void graph_edges(int vertex, int node, int scope);
+	void type_refs(int node, int scope, int_v& ids);
+	int graph_id(int vertex);
+	int graph_vertex(int id);
+	// -------------------------------------------------------------------------
+	// keep only the types reachable from the roots (type ids), see TypeGraph_t::used
+	int prune(const int_v& roots);
+	int_v topics();
+	int keyed(int i);
+	int_v all_types();
+	// -------------------------------------------------------------------------
+	// in-memory layout (natural alignment) and key path(s), see resolve()
+	int type_layout(int node, int scope, int& align);
+	int typedef_layout(const Typedef_t& td, int& align);
+	void layout_struct(int i);
+	void resolve_keys(int i);
+	int key_path(int i, const char* path, KeyPath_t& key);
+	int find_keylist(const Keylist_t& keylist);
+	// -------------------------------------------------------------------------
+	// extensibility : ANN_FINAL, ANN_APPENDABLE (def) or ANN_MUTABLE
+	static int extensibility(const Struct_t& str);
+	int is_primitive(int node, int scope);
+	void member_table(int i);
+	void inherit(int i);
+	// -------------------------------------------------------------------------
+	// classes (see TypeClass_e) and padding, report of the layout / cost
+	int type_class(int node, int scope);
+	int typedef_class(const Typedef_t& td);
+	void classify(int i);
+	void report(std::ostream& os);
+	// -------------------------------------------------------------------------
+	// serialized size (Encoding_e) : end of the stream from 'pos', -1 unbounded
+	int xcdr_type(int node, int scope, int enc, int pos, int max);
+	int xcdr_elements(int node, int mapped, int scope, int enc, int pos,
+		int count, int max);
+	int xcdr_array(int node, int scope, int dims, const int* array, int enc,
+		int pos, int max);
+	int xcdr_struct(int i, int enc, int pos, int max);
+	int xcdr_members(int i, int enc, int pos, int max);
+	void serialized_size(int i);
+	void size_constants(int i, std::ostream& os);
+	// -------------------------------------------------------------------------
+	// union : case label(s) > value(s) > branch
+	int real_type(int node, int scope);
+	int label_value(const Span_t& label, int disc, int scope, int& value);
+	void case_table(int i);
+	int is_used(int id);
+	int find(const char* name);
+	// -------------------------------------------------------------------------
+	// call fn(ctx, i) for i in [0, count) on 'threads' thread(s)
+	static void parallel(int count, void (*fn)(void* ctx, int i), void* ctx,
+		int threads);
 	// -------------------------------------------------------------------------
 	int getType(const hash_t& hash);
 	// -------------------------------------------------------------------------
@@ -250,23 +874,51 @@ public:
 	// -------------------------------------------------------------------------
 	inline void clear()
 	{
+		enums.clear();
 		structs.clear();
+		typedefs.clear();
+		nodes.clear();
+		resolved.clear();
+		resolving.clear();
+		graph = TypeGraph_t();
 		variables.clear();
 		udefines.clear();
 		modules.clear();
+		keylists.clear();
+		consts.clear();
+		interfaces.clear();
+		types.clear();
+		modules.push_back( Module_t() ); // global scope
+		scope = 0;
+		annotation = Annotation_t();
 	}
 
 	// -------------------------------------------------------------------------
 	Enum_t_v enums;
 	Typedef_t_v typedefs;
 	Struct_t_v structs;
-	Variable_t_v variables;
+	Variable_t_v variables; // global variable(s), a field is in Struct_t::fields
 	Module_t_v modules;
+	Keylist_t_v keylists; // #pragma keylist
+	Const_t_v consts;
+	Interface_t_v interfaces;
+	TypeNode_t_v nodes; // all type trees (see Typedef_t::node)
+	Map<hash_t, int> types; // hash(name) > first type declared with this name
+	Typedef_t_v resolved;	// real type of each typedef (see resolve())
+	int_v resolving;		// 0: todo, 1: in progress, 2: done
+	TypeGraph_t graph;		// dependency graph of the user types
 
 	// dispatched command for easy access
 	UDefine_t_v udefines;
 	
 	String nameSpace; /* current namespace "::" or '' == global */
+	int scope; /* current module (index in modules) */
+
+	int span_model; // def : false, see OPT_SPAN_MODEL
+	int threads; // worker thread(s) for resolve() / generate(), 0: all cores
+	int lazy; // def : false, see OPT_LAZY
+	int reorder; // def : false, see OPT_REORDER
+	Annotation_t annotation; // type annotation(s) waiting for their declaration
 
 }; // end of class Parser
 
@@ -277,18 +929,38 @@ class IdlParser : public Parser
 {
 public:
 	IdlParser() : Parser(), code(), defines(), linearize(0),
-		generate_comment(1) {/** call String optimize(String code) */}
-	IdlParser(const String& file);
-	~IdlParser() { defines.clear(); code.clear(); }
+		generate_comment(1), prune_topics(0), report_layout(0), pmr(0),
+		source(NULL), sources() {/** call String optimize(String code) */}
+	IdlParser(const String& file, int options = OPT_NONE);
+	~IdlParser()
+	{
+		defines.clear(); code.clear(); free(source);
+		for (int i = 0; i < sources.size(); ++i) free(sources[i]);
+	}
 
 	/**/
 	virtual String user_optimize() { return ""; };
+	// code of one user type (see graph_id()), called from worker thread(s) :
+	// must only read the model
+	virtual String user_generate(int /*id*/) { return ""; }
+	String generate();
 	String optimize(const char* file, const String& code);
 	String getExtensions();
 
 	// -------------------------------------------------------------------------
 	String var2Real(const Variable_t& v);
 
+	// -------------------------------------------------------------------------
+	// generated C++ : map templates, type of a type tree, allocator-aware
+	// struct (OPT_PMR)
+	void cxx_support(std::ostream& os);
+	void cxx_type(int node, int scope, std::ostream& os);
+	int allocates(int node, int scope);
+	int union_allocates(int node, int scope);
+	int inline_allocates(const Variable_t& v);
+	int cxx_array(const Variable_t& v);
+	void cxx_allocator(int i, std::ostream& os);
+
 	// -------------------------------------------------------------------------
 	inline void define(const char *name,const char *value)
 	{
@@ -332,6 +1004,20 @@ public:
 
 	int linearize; // def : false
 	int generate_comment; // default off
+	int prune_topics; // def : false, see OPT_PRUNE
+	int report_layout; // def : false, see OPT_REPORT
+	int pmr; // def : false, see OPT_PMR
+
+	// preprocessed source, kept alive for the Span_t of the model
+	char *source;
+	// source(s) of the previous optimize() call(s) : the model still points
+	// into them, freed with the parser
+	Vector<char*> sources;
+
+private:
+	// owns 'source' (and the model points into it) : not copyable
+	IdlParser(const IdlParser&);
+	IdlParser& operator=(const IdlParser&);
 
 }; // end of class IdlParser
 